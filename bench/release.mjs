@@ -0,0 +1,136 @@
+// release.mjs — Compare build profiles: size, startup and throughput
+// For each label=dir, reads dir/node_ward.wasm and dir/bench.wasm and
+// reports:
+//   - binary size, raw and gzip/brotli compressed (what a page downloads)
+//   - cold instantiate time: compile + instantiate of node_ward.wasm, each
+//     run in a fresh Node process so no in-process code cache is reused
+//   - WASM benchmark results (bench/run.mjs on dir/bench.wasm), each
+//     profile's raw run kept as bench-<label>.json next to --out so no
+//     profile (dev=build in particular) overwrites build/bench.json
+// and writes them to --out as JSON.
+//
+// Usage: node bench/release.mjs dev=build size=build/release/size ...
+//          [--warmup 3] [--reps 10] [--out build/release/report.json]
+
+import { spawnSync } from 'node:child_process';
+import { readFileSync, writeFileSync, existsSync, mkdirSync } from 'node:fs';
+import { dirname, join } from 'node:path';
+import { fileURLToPath } from 'node:url';
+import { parseArgs } from 'node:util';
+import { gzipSync, brotliCompressSync } from 'node:zlib';
+
+const here = dirname(fileURLToPath(import.meta.url));
+
+// Child mode: one cold compile + instantiate, prints "<compile> <instantiate>"
+async function probe(path) {
+  const bytes = readFileSync(path);
+  const t0 = performance.now();
+  const module = await WebAssembly.compile(bytes);
+  const t1 = performance.now();
+  const env = {};
+  for (const imp of WebAssembly.Module.imports(module)) {
+    if (imp.module === 'env' && imp.kind === 'function') env[imp.name] = () => 0;
+  }
+  await WebAssembly.instantiate(module, { env });
+  const t2 = performance.now();
+  console.log(`${t1 - t0} ${t2 - t1}`);
+}
+
+function median(xs) {
+  const s = [...xs].sort((a, b) => a - b);
+  const m = s.length >> 1;
+  return s.length % 2 ? s[m] : (s[m - 1] + s[m]) / 2;
+}
+
+function startup(path, reps) {
+  const compile = [];
+  const instantiate = [];
+  for (let i = 0; i < reps; i++) {
+    const r = spawnSync(process.execPath, [fileURLToPath(import.meta.url), '--probe', path],
+      { encoding: 'utf8' });
+    if (r.status !== 0) throw new Error(`probe ${path}: ${r.stderr}`);
+    const [c, n] = r.stdout.trim().split(' ').map(Number);
+    compile.push(c);
+    instantiate.push(n);
+  }
+  return {
+    compile_ms: median(compile),
+    instantiate_ms: median(instantiate),
+    total_ms: median(compile.map((c, i) => c + instantiate[i])),
+  };
+}
+
+function sizes(path) {
+  const bytes = readFileSync(path);
+  return {
+    bytes: bytes.length,
+    gzip: gzipSync(bytes, { level: 9 }).length,
+    brotli: brotliCompressSync(bytes).length,
+  };
+}
+
+function bench(path, warmup, reps, out) {
+  const r = spawnSync(process.execPath, [join(here, 'run.mjs'),
+    '--native', '', '--wasm', path, '--baseline', '', '--out', out,
+    '--warmup', String(warmup), '--reps', String(reps)], { encoding: 'utf8' });
+  if (r.status !== 0) throw new Error(`bench ${path}: ${r.stderr}`);
+  const results = JSON.parse(readFileSync(out, 'utf8')).results;
+  return Object.fromEntries(results.map(x => [x.name, x.ns_per_iter]));
+}
+
+async function main() {
+  const { values, positionals } = parseArgs({
+    allowPositionals: true,
+    options: {
+      probe: { type: 'string' },
+      warmup: { type: 'string', default: '3' },
+      reps: { type: 'string', default: '10' },
+      out: { type: 'string', default: 'build/release/report.json' },
+    },
+  });
+  if (values.probe) return probe(values.probe);
+
+  const warmup = Number(values.warmup);
+  const reps = Number(values.reps);
+  const outDir = dirname(values.out);
+  mkdirSync(outDir, { recursive: true });
+  const profiles = [];
+  for (const arg of positionals) {
+    const [label, dir] = arg.includes('=') ? arg.split('=') : [arg, arg];
+    const app = join(dir, 'node_ward.wasm');
+    const benchWasm = join(dir, 'bench.wasm');
+    if (!existsSync(app)) {
+      console.error(`${app}: not built, ${label} skipped`);
+      continue;
+    }
+    const p = { label, dir, size: sizes(app), startup: startup(app, reps) };
+    if (existsSync(benchWasm)) {
+      p.bench_ns_per_iter = bench(benchWasm, warmup, reps, join(outDir, `bench-${label}.json`));
+    }
+    profiles.push(p);
+  }
+
+  const col = (s) => String(s).padStart(12);
+  console.log(''.padEnd(22) + profiles.map(p => col(p.label)).join(''));
+  const row = (name, f) => console.log(name.padEnd(22) + profiles.map(p => col(f(p))).join(''));
+  row('size (bytes)', p => p.size.bytes);
+  row('gzip', p => p.size.gzip);
+  row('brotli', p => p.size.brotli);
+  row('compile (ms)', p => p.startup.compile_ms.toFixed(2));
+  row('instantiate (ms)', p => p.startup.instantiate_ms.toFixed(2));
+  const names = [...new Set(profiles.flatMap(p => Object.keys(p.bench_ns_per_iter || {})))];
+  for (const n of names) {
+    row(`${n} (ns/iter)`, p => {
+      const v = p.bench_ns_per_iter && p.bench_ns_per_iter[n];
+      return v === undefined ? '-' : v.toFixed(1);
+    });
+  }
+
+  writeFileSync(values.out, JSON.stringify({
+    version: 1, date: new Date().toISOString(), node: process.version,
+    warmup, reps, profiles,
+  }, null, 2) + '\n');
+  console.log(`\n==> ${values.out}`);
+}
+
+await main();
@@ -0,0 +1,268 @@
+// run.mjs — Benchmark harness: times the ward kernels natively and in WASM
+// Each kernel (bench/bench.dats) runs `warmup` untimed and `reps` timed
+// rounds per target. WASM kernels are called through the ward_bench_run
+// export; the native binary (bench_native.dats) is spawned once per kernel
+// and reports per-run times. The bridge decoder is timed on the DOM batches
+// the WASM dom_encode kernel produced, applied to jsdom.
+//
+// Writes machine-readable JSON (--out) and, given a baseline from an
+// earlier run, fails when any benchmark's median time per iteration grows
+// by more than --threshold (a fraction; 0.10 = 10%).
+//
+// Usage: node bench/run.mjs [--native build/bench_native] [--wasm build/bench.wasm]
+//          [--warmup 3] [--reps 10] [--scale 1] [--filter name]
+//          [--out build/bench.json] [--baseline bench/baseline.json]
+//          [--threshold 0.10] [--save-baseline] [--require-baseline]
+// An empty --native or --wasm skips that target; an empty --baseline skips
+// the comparison. --require-baseline (used by `make bench`) fails instead
+// of skipping when the baseline file does not exist.
+
+import { spawnSync } from 'node:child_process';
+import { readFile, writeFile } from 'node:fs/promises';
+import { existsSync } from 'node:fs';
+import { parseArgs } from 'node:util';
+import os from 'node:os';
+import { createWardHost } from '../lib/ward_bridge.mjs';
+
+// Kernel IDs — must match ward_bench_run in bench.dats. iters is sized for
+// a few milliseconds per run; --scale multiplies it.
+export const KERNELS = [
+  { id: 0, name: 'alloc', iters: 20000 },      // 5 blocks across size classes
+  { id: 1, name: 'arena', iters: 20000 },      // create, 3 allocs, destroy
+  { id: 2, name: 'memcpy', iters: 1000 },      // 64KB copy
+  { id: 3, name: 'memset', iters: 1000 },      // 64KB zeroing allocation
+  { id: 4, name: 'text', iters: 2000 },        // 4KB SAFE_CHAR scan
+  { id: 5, name: 'dom_encode', iters: 20000 }, // create, attr, text, remove
+  { id: 6, name: 'promise', iters: 5000 },     // depth-8 then chain
+  { id: 7, name: 'xml', iters: 500 },          // 128-record SAX walk
+];
+
+// Rounds of the recorded dom_encode batches applied per bridge_decode run
+const DECODE_ITERS = 5000;
+
+function summarize(target, name, iters, ms, checksum) {
+  const sorted = [...ms].sort((a, b) => a - b);
+  const mid = sorted.length >> 1;
+  const median = sorted.length % 2 ? sorted[mid] : (sorted[mid - 1] + sorted[mid]) / 2;
+  const mean = ms.reduce((a, b) => a + b, 0) / ms.length;
+  const variance = ms.reduce((a, b) => a + (b - mean) ** 2, 0) / ms.length;
+  return {
+    target, name, iters, reps: ms.length,
+    median_ms: median, min_ms: sorted[0], max_ms: sorted[sorted.length - 1],
+    mean_ms: mean, stddev_ms: Math.sqrt(variance),
+    ns_per_iter: (median * 1e6) / iters,
+    checksum, samples_ms: ms,
+  };
+}
+
+function measure(fn, warmup, reps) {
+  for (let i = 0; i < warmup; i++) fn();
+  const ms = [];
+  let checksum = 0;
+  for (let i = 0; i < reps; i++) {
+    const t0 = performance.now();
+    checksum = fn();
+    ms.push(performance.now() - t0);
+  }
+  return { ms, checksum };
+}
+
+// --- WASM ---
+
+async function loadBenchWasm(path) {
+  const module = await WebAssembly.compile(await readFile(path));
+  let onFlush = null;
+  const env = {};
+  for (const imp of WebAssembly.Module.imports(module)) {
+    if (imp.module === 'env' && imp.kind === 'function') env[imp.name] = () => 0;
+  }
+  env.ward_dom_flush = (ptr, len) => { if (onFlush) onFlush(ptr, len); };
+  const instance = await WebAssembly.instantiate(module, { env });
+  return {
+    run: (id, iters) => instance.exports.ward_bench_run(id, iters),
+    // Copy out every batch one run of the kernel flushes
+    record(id, iters) {
+      const batches = [];
+      onFlush = (ptr, len) => {
+        batches.push(new Uint8Array(instance.exports.memory.buffer, ptr, len).slice());
+      };
+      try {
+        instance.exports.ward_bench_run(id, iters);
+      } finally {
+        onFlush = null;
+      }
+      return batches;
+    },
+  };
+}
+
+// --- Native ---
+
+function runNative(path, k, iters, warmup, reps) {
+  const r = spawnSync(path, [k.id, iters, warmup, reps].map(String), { encoding: 'utf8' });
+  if (r.status !== 0) {
+    throw new Error(`${path} ${k.name}: exit ${r.status}\n${r.stderr}`);
+  }
+  const ms = [];
+  let checksum = 0;
+  for (const line of r.stdout.trim().split('\n')) {
+    const [t, c] = line.trim().split(/\s+/);
+    ms.push(Number(t));
+    checksum = Number(c);
+  }
+  return { ms, checksum };
+}
+
+// --- Bridge decode ---
+
+async function benchDecode(batches, warmup, reps, iters) {
+  let JSDOM;
+  try {
+    ({ JSDOM } = await import('jsdom'));
+  } catch (e) {
+    console.error('bridge_decode: jsdom not installed, skipped');
+    return null;
+  }
+  const dom = new JSDOM('<!DOCTYPE html><div id="ward-root"></div>');
+  const root = dom.window.document.getElementById('ward-root');
+  const host = createWardHost(root);
+
+  // Lay the batches out back to back in a memory the decoder reads from
+  const total = batches.reduce((a, b) => a + b.length, 0);
+  const memory = new WebAssembly.Memory({ initial: Math.ceil(total / 65536) + 1 });
+  const mem = new Uint8Array(memory.buffer);
+  const spans = [];
+  let off = 0;
+  for (const b of batches) {
+    mem.set(b, off);
+    spans.push([off, b.length]);
+    off += b.length;
+  }
+  host.attach({ exports: { memory } });
+  const flush = host.imports.env.ward_dom_flush;
+  const { ms, checksum } = measure(() => {
+    for (const [p, len] of spans) flush(p, len);
+    return host.nodes.size;
+  }, warmup, reps);
+  return summarize('js', 'bridge_decode', iters, ms, checksum);
+}
+
+// --- Baseline comparison ---
+
+function compare(results, baseline, threshold) {
+  const base = new Map(baseline.results.map(r => [`${r.target}/${r.name}`, r]));
+  const rows = [];
+  for (const r of results) {
+    const b = base.get(`${r.target}/${r.name}`);
+    if (!b) continue;
+    const ratio = r.ns_per_iter / b.ns_per_iter;
+    const status = ratio > 1 + threshold ? 'regression'
+      : ratio < 1 - threshold ? 'improved' : 'ok';
+    rows.push({ target: r.target, name: r.name, baseline_ns: b.ns_per_iter,
+      ns: r.ns_per_iter, ratio, status });
+  }
+  return rows;
+}
+
+function fmt(x, w) {
+  return String(x).padStart(w);
+}
+
+async function main() {
+  const { values } = parseArgs({
+    options: {
+      native: { type: 'string', default: 'build/bench_native' },
+      wasm: { type: 'string', default: 'build/bench.wasm' },
+      warmup: { type: 'string', default: '3' },
+      reps: { type: 'string', default: '10' },
+      scale: { type: 'string', default: '1' },
+      filter: { type: 'string' },
+      out: { type: 'string', default: 'build/bench.json' },
+      baseline: { type: 'string', default: 'bench/baseline.json' },
+      threshold: { type: 'string', default: '0.10' },
+      'save-baseline': { type: 'boolean', default: false },
+      'require-baseline': { type: 'boolean', default: false },
+    },
+  });
+  if (values['require-baseline'] && !values['save-baseline'] &&
+      !(values.baseline && existsSync(values.baseline))) {
+    console.error(`${values.baseline || '--baseline'}: no baseline to compare against; ` +
+      'record one with `make bench-baseline`');
+    process.exit(1);
+  }
+  const warmup = Number(values.warmup);
+  const reps = Number(values.reps);
+  const scale = Number(values.scale);
+  const threshold = Number(values.threshold);
+  const kernels = KERNELS.filter(k => !values.filter || k.name.includes(values.filter));
+
+  const results = [];
+  const log = (r) => {
+    results.push(r);
+    console.log(`${fmt(r.target, 6)} ${r.name.padEnd(14)} ${fmt(r.median_ms.toFixed(3), 10)} ms ` +
+      `${fmt(r.ns_per_iter.toFixed(1), 10)} ns/iter  ±${r.stddev_ms.toFixed(3)}`);
+  };
+
+  if (values.native && existsSync(values.native)) {
+    for (const k of kernels) {
+      const iters = Math.max(1, Math.round(k.iters * scale));
+      const { ms, checksum } = runNative(values.native, k, iters, warmup, reps);
+      log(summarize('native', k.name, iters, ms, checksum));
+    }
+  } else if (values.native) {
+    console.error(`${values.native}: not built, native benchmarks skipped`);
+  }
+
+  if (values.wasm && existsSync(values.wasm)) {
+    const wasm = await loadBenchWasm(values.wasm);
+    for (const k of kernels) {
+      const iters = Math.max(1, Math.round(k.iters * scale));
+      const { ms, checksum } = measure(() => wasm.run(k.id, iters), warmup, reps);
+      log(summarize('wasm', k.name, iters, ms, checksum));
+    }
+    if (!values.filter || 'bridge_decode'.includes(values.filter)) {
+      const iters = Math.max(1, Math.round(DECODE_ITERS * scale));
+      const batches = wasm.record(5, iters); // dom_encode
+      const r = await benchDecode(batches, warmup, reps, iters);
+      if (r) log(r);
+    }
+  } else if (values.wasm) {
+    console.error(`${values.wasm}: not built, WASM benchmarks skipped`);
+  }
+
+  const report = {
+    version: 1,
+    date: new Date().toISOString(),
+    node: process.version,
+    platform: `${os.platform()}-${os.arch()}`,
+    cpu: (os.cpus()[0] || {}).model || 'unknown',
+    warmup, reps, scale,
+    results,
+  };
+
+  let failed = false;
+  if (!values['save-baseline'] && values.baseline && existsSync(values.baseline)) {
+    const baseline = JSON.parse(await readFile(values.baseline, 'utf8'));
+    report.comparison = { baseline: values.baseline, threshold,
+      rows: compare(results, baseline, threshold) };
+    console.log(`\nvs ${values.baseline} (threshold ${(threshold * 100).toFixed(0)}%):`);
+    for (const row of report.comparison.rows) {
+      console.log(`${fmt(row.target, 6)} ${row.name.padEnd(14)} ` +
+        `${fmt((row.ratio * 100 - 100).toFixed(1), 7)}%  ${row.status}`);
+      if (row.status === 'regression') failed = true;
+    }
+  }
+
+  await writeFile(values.out, JSON.stringify(report, null, 2) + '\n');
+  console.log(`\n==> ${values.out}`);
+  if (values['save-baseline']) {
+    await writeFile(values.baseline, JSON.stringify(report, null, 2) + '\n');
+    console.log(`==> baseline saved to ${values.baseline}`);
+  }
+  if (failed) {
+    console.error('==> performance regression');
+    process.exit(1);
+  }
+}
+
+await main();
@@ -4,6 +4,204 @@
 extern unsigned char __heap_base;
 static unsigned char *heap_ptr = &__heap_base;
 
+/* --- Threaded build (WARD_THREADS) ---
+ *
+ * Memory is shared between the worker running the program, ward_par
+ * helper instances and the main thread applying DOM batches. Small blocks
+ * come from per-thread caches (see malloc below); the shared heap behind
+ * them is guarded by a futex-style lock (0 = free, 1 = held, 2 = held with
+ * waiters) parked with memory.atomic.wait; the resolver and listener
+ * tables use atomic slot operations. Single-threaded builds compile all of
+ * this down to plain loads and stores.
+ */
+
+#ifdef WARD_THREADS
+static int ward_heap_lock = 0;
+
+static inline void ward_lock(int *l) {
+    int c = 0;
+    if (__atomic_compare_exchange_n(l, &c, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return;
+    if (c != 2) c = __atomic_exchange_n(l, 2, __ATOMIC_ACQUIRE);
+    while (c != 0) {
+        __builtin_wasm_memory_atomic_wait32(l, 2, -1);
+        c = __atomic_exchange_n(l, 2, __ATOMIC_ACQUIRE);
+    }
+}
+
+static inline void ward_unlock(int *l) {
+    if (__atomic_fetch_sub(l, 1, __ATOMIC_RELEASE) != 1) {
+        __atomic_store_n(l, 0, __ATOMIC_RELEASE);
+        __builtin_wasm_memory_atomic_notify(l, 1);
+    }
+}
+
+static inline int ward_slot_claim(void **slot, void *v) {
+    void *expected = (void*)0;
+    return __atomic_compare_exchange_n(slot, &expected, v, 0,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+static inline void *ward_slot_take(void **slot) {
+    return __atomic_exchange_n(slot, (void*)0, __ATOMIC_ACQ_REL);
+}
+static inline void ward_slot_store(void **slot, void *v) {
+    __atomic_store_n(slot, v, __ATOMIC_RELEASE);
+}
+static inline void *ward_slot_load(void **slot) {
+    return __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+}
+#else
+#define ward_lock(l) ((void)0)
+#define ward_unlock(l) ((void)0)
+
+static inline int ward_slot_claim(void **slot, void *v) {
+    if (*slot) return 0;
+    *slot = v;
+    return 1;
+}
+static inline void *ward_slot_take(void **slot) {
+    void *v = *slot;
+    *slot = (void*)0;
+    return v;
+}
+static inline void ward_slot_store(void **slot, void *v) { *slot = v; }
+static inline void *ward_slot_load(void **slot) { return *slot; }
+#endif
+
+/* --- Instrumentation (WARD_STATS) ---
+ *
+ * Counters for the allocator, the resolver/listener tables, DOM flushes
+ * and promise chain resolution, laid out as consecutive i32 fields so the
+ * bridge can read them straight out of memory (ward_stats.mjs mirrors the
+ * field order). Without WARD_STATS every hook is an empty inline function.
+ *
+ * Allocation classes 0-8 are the free-list buckets, 9 is oversized. The
+ * header padding word records the requested size, so live_bytes minus
+ * live_requested is internal fragmentation and free_list_bytes is memory
+ * parked on free lists. Counters are 32-bit and wrap.
+ */
+
+#define WARD_STATS_VERSION 1
+#define WARD_STATS_CLASSES 10
+#define WARD_STATS_DEPTHS 6  /* chain depth 1, 2, 3-4, 5-8, 9-16, 17+ */
+
+#ifdef WARD_STATS
+typedef struct {
+    int version;
+    int nfields;
+    int alloc_count[WARD_STATS_CLASSES];
+    int free_count[WARD_STATS_CLASSES];
+    int live_bytes;
+    int live_requested;
+    int peak_bytes;
+    int heap_bytes;
+    int free_list_bytes;
+    int flush_count;
+    int flush_bytes;
+    int flush_max;
+    int resolvers_live;
+    int resolvers_peak;
+    int listeners_live;
+    int listeners_peak;
+    int chain_resolves;
+    int chain_max_depth;
+    int chain_depth_hist[WARD_STATS_DEPTHS];
+} ward_stats_t;
+
+static ward_stats_t _ward_stats = {
+    WARD_STATS_VERSION, (int)(sizeof(ward_stats_t) / sizeof(int))
+};
+
+#ifdef WARD_THREADS
+/* Each thread walks its own promise chains */
+static _Thread_local int _ward_chain_depth = 0;
+#define WARD_STAT_ADD(f, v) __atomic_add_fetch(&(f), (v), __ATOMIC_RELAXED)
+
+static inline void ward_stat_peak(int *peak, int v) {
+    int cur = __atomic_load_n(peak, __ATOMIC_RELAXED);
+    while (v > cur &&
+           !__atomic_compare_exchange_n(peak, &cur, v, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+}
+#else
+static int _ward_chain_depth = 0;
+#define WARD_STAT_ADD(f, v) ((f) += (v))
+
+static inline void ward_stat_peak(int *peak, int v) {
+    if (v > *peak) *peak = v;
+}
+#endif
+
+/* Allocator hooks — thread-cache hits run without the heap lock */
+static inline void ward_stat_alloc(int cls, unsigned int bsz, unsigned int req) {
+    WARD_STAT_ADD(_ward_stats.alloc_count[cls], 1);
+    int live = WARD_STAT_ADD(_ward_stats.live_bytes, (int)bsz);
+    WARD_STAT_ADD(_ward_stats.live_requested, (int)req);
+    ward_stat_peak(&_ward_stats.peak_bytes, live);
+}
+static inline void ward_stat_free(int cls, unsigned int bsz, unsigned int req) {
+    WARD_STAT_ADD(_ward_stats.free_count[cls], 1);
+    WARD_STAT_ADD(_ward_stats.live_bytes, -(int)bsz);
+    WARD_STAT_ADD(_ward_stats.live_requested, -(int)req);
+    WARD_STAT_ADD(_ward_stats.free_list_bytes, (int)bsz);
+}
+static inline void ward_stat_reuse(unsigned int bsz) {
+    WARD_STAT_ADD(_ward_stats.free_list_bytes, -(int)bsz);
+}
+static inline void ward_stat_heap(void) {
+    _ward_stats.heap_bytes = (int)(heap_ptr - &__heap_base);
+}
+
+/* Table hooks — d is +1 when a slot fills, -1 when it empties */
+static inline void ward_stat_resolvers(int d) {
+    int live = WARD_STAT_ADD(_ward_stats.resolvers_live, d);
+    ward_stat_peak(&_ward_stats.resolvers_peak, live);
+}
+static inline void ward_stat_listeners(int d) {
+    int live = WARD_STAT_ADD(_ward_stats.listeners_live, d);
+    ward_stat_peak(&_ward_stats.listeners_peak, live);
+}
+
+/* Exported so the bridge (or a threaded loader) can find the counters */
+void *ward_stats(void) {
+    return &_ward_stats;
+}
+
+void ward_stats_flush(int len) {
+    WARD_STAT_ADD(_ward_stats.flush_count, 1);
+    WARD_STAT_ADD(_ward_stats.flush_bytes, len);
+    ward_stat_peak(&_ward_stats.flush_max, len);
+}
+
+/* Chain depth = nodes walked by one resolve. begin/end nest, so a resolve
+   triggered from inside a then-callback is measured on its own. */
+int ward_stats_chain_begin(void) {
+    int saved = _ward_chain_depth;
+    _ward_chain_depth = 0;
+    return saved;
+}
+
+void ward_stats_chain_step(void) {
+    _ward_chain_depth++;
+}
+
+void ward_stats_chain_end(int saved) {
+    int d = _ward_chain_depth;
+    int b = d <= 1 ? 0 : d <= 2 ? 1 : d <= 4 ? 2 : d <= 8 ? 3 : d <= 16 ? 4 : 5;
+    WARD_STAT_ADD(_ward_stats.chain_resolves, 1);
+    WARD_STAT_ADD(_ward_stats.chain_depth_hist[b], 1);
+    ward_stat_peak(&_ward_stats.chain_max_depth, d);
+    _ward_chain_depth = saved;
+}
+#else
+static inline void ward_stat_alloc(int cls, unsigned int bsz, unsigned int req) {}
+static inline void ward_stat_free(int cls, unsigned int bsz, unsigned int req) {}
+static inline void ward_stat_reuse(unsigned int bsz) {}
+static inline void ward_stat_heap(void) {}
+static inline void ward_stat_resolvers(int d) {}
+static inline void ward_stat_listeners(int d) {}
+#endif
+
 /* --- Free-list allocator with size classes ---
  *
  * Block layout:  [header: 8 bytes][user area ...]
@@ -11,6 +209,7 @@ static unsigned char *heap_ptr = &__heap_base;
  *
  * Header stores usable size (4 bytes) + 4 bytes padding so the user
  * pointer stays 8-byte aligned when the block start is 8-byte aligned.
+ * WARD_STATS builds keep the requested size in the padding word.
  *
  * Free blocks: first word of user area is the next-free pointer.
  * No separate metadata -- the chain lives inside freed blocks.
@@ -37,6 +236,14 @@ static inline void ward_hdr_write(void *p, unsigned int sz) {
     *(unsigned int *)((char *)p - WARD_HEADER) = sz;
 }
 
+static inline unsigned int ward_hdr_req(void *p) {
+    return *(unsigned int *)((char *)p - WARD_HEADER + 4);
+}
+
+static inline void ward_hdr_set_req(void *p, unsigned int req) {
+    *(unsigned int *)((char *)p - WARD_HEADER + 4) = req;
+}
+
 static inline int ward_bucket(unsigned int n) {
     if (n <= 32)      return 0;
     if (n <= 128)     return 1;
@@ -63,13 +270,13 @@ static void *ward_bump(unsigned int usable) {
     *(unsigned int *)a = usable;               /* write size header */
     void *p = (void *)(a + WARD_HEADER);       /* user pointer      */
     heap_ptr = (unsigned char *)end;
+    ward_stat_heap();
     return p;
 }
 
-void *malloc(int size) {
-    if (size <= 0) size = 1;
-    unsigned int n = (unsigned int)size;
-
+/* Pop or carve a block for n bytes; *zlen receives the length to zero.
+   Caller holds the heap lock. */
+static void *ward_alloc_block(unsigned int n, unsigned int *zlen) {
     /* Bucketed path */
     int b = ward_bucket(n);
     if (b >= 0) {
@@ -78,10 +285,11 @@ void *malloc(int size) {
         if (ward_fl[b]) {
             p = ward_fl[b];
             ward_fl[b] = *(void **)p;
+            ward_stat_reuse(bsz);
         } else {
             p = ward_bump(bsz);
         }
-        memset(p, 0, bsz);
+        *zlen = bsz;
         return p;
     }
 
@@ -92,7 +300,8 @@ void *malloc(int size) {
         unsigned int bsz = ward_hdr_read(cur);
         if (bsz >= n && bsz <= 2 * n) {
             *prev = *(void **)cur;
-            memset(cur, 0, bsz);
+            ward_stat_reuse(bsz);
+            *zlen = bsz;
             return cur;
         }
         prev = (void **)cur;
@@ -100,8 +309,116 @@ void *malloc(int size) {
     }
 
     /* No fit -- bump */
-    void *p = ward_bump(n);
-    memset(p, 0, n);
+    *zlen = n;
+    return ward_bump(n);
+}
+
+#ifdef WARD_THREADS
+/* --- Per-thread caches (threaded build) ---
+ *
+ * Each instance (program worker, ward_par helpers) keeps its own free
+ * lists for the small classes (32..4096 bytes) in wasm TLS, so par_map /
+ * par_sort tasks allocate and free without touching the heap lock. A
+ * thread takes the lock only to refill an empty class with up to
+ * WARD_TC_BATCH blocks from the shared lists (or bump one), and to hand
+ * half of a class back once it holds more than WARD_TC_MAX. Larger
+ * classes and oversized blocks always use the shared lists.
+ *
+ * TLS blocks come from ward_mt_tls_block: ward_mt_init installs one for
+ * the program worker, ward_par_init allocates one per helper.
+ */
+
+#define WARD_TC_CLASSES 4
+#define WARD_TC_BATCH 16
+#define WARD_TC_MAX 64
+
+typedef struct {
+    void *head[WARD_TC_CLASSES];
+    int count[WARD_TC_CLASSES];
+} ward_tcache;
+
+static _Thread_local ward_tcache ward_tc;
+
+extern void __wasm_init_tls(void *block);
+
+static void *ward_tc_alloc(int b) {
+    if (!ward_tc.head[b]) {
+        void *fresh = (void*)0;
+        ward_lock(&ward_heap_lock);
+        for (int i = 0; i < WARD_TC_BATCH && ward_fl[b]; i++) {
+            void *q = ward_fl[b];
+            ward_fl[b] = *(void **)q;
+            *(void **)q = ward_tc.head[b];
+            ward_tc.head[b] = q;
+            ward_tc.count[b]++;
+        }
+        if (!ward_tc.head[b]) fresh = ward_bump(ward_bsz[b]);
+        ward_unlock(&ward_heap_lock);
+        if (!ward_tc.head[b]) return fresh;
+    }
+    void *p = ward_tc.head[b];
+    ward_tc.head[b] = *(void **)p;
+    ward_tc.count[b]--;
+    ward_stat_reuse(ward_bsz[b]);
+    return p;
+}
+
+static void ward_tc_free(int b, void *p) {
+    *(void **)p = ward_tc.head[b];
+    ward_tc.head[b] = p;
+    if (++ward_tc.count[b] <= WARD_TC_MAX) return;
+    ward_lock(&ward_heap_lock);
+    while (ward_tc.count[b] > WARD_TC_MAX / 2) {
+        void *q = ward_tc.head[b];
+        ward_tc.head[b] = *(void **)q;
+        ward_tc.count[b]--;
+        *(void **)q = ward_fl[b];
+        ward_fl[b] = q;
+    }
+    ward_unlock(&ward_heap_lock);
+}
+
+/* A TLS block for one instance, carved straight from the heap: the caller
+   has no TLS yet, so this must not go through malloc's thread cache */
+void *ward_mt_tls_block(void) {
+    unsigned int align = (unsigned int)__builtin_wasm_tls_align();
+    unsigned int size = (unsigned int)__builtin_wasm_tls_size();
+    if (align < 8) align = 8;
+    ward_lock(&ward_heap_lock);
+    void *p = ward_bump(size + align);
+    ward_unlock(&ward_heap_lock);
+    if (!p) return (void*)0;
+    unsigned long a = ((unsigned long)p + align - 1) & ~(unsigned long)(align - 1);
+    memset((void *)a, 0, size);
+    return (void *)a;
+}
+#endif
+
+void *malloc(int size) {
+    if (size <= 0) size = 1;
+    unsigned int zlen = 0;
+    void *p = (void*)0;
+#if defined(WARD_THREADS) || defined(WARD_STATS)
+    int b = ward_bucket((unsigned int)size);
+#endif
+#ifdef WARD_THREADS
+    if (b >= 0 && b < WARD_TC_CLASSES) {
+        p = ward_tc_alloc(b);
+        zlen = ward_bsz[b];
+    } else
+#endif
+    {
+        ward_lock(&ward_heap_lock);
+        p = ward_alloc_block((unsigned int)size, &zlen);
+        ward_unlock(&ward_heap_lock);
+    }
+#ifdef WARD_STATS
+    if (p) {
+        ward_hdr_set_req(p, (unsigned int)size);
+        ward_stat_alloc(b >= 0 ? b : WARD_NBUCKET, zlen, (unsigned int)size);
+    }
+#endif
+    if (p) memset(p, 0, zlen);   /* block is caller-owned: zero outside lock */
     return p;
 }
 
@@ -109,13 +426,23 @@ void free(void *ptr) {
     if (!ptr) return;
     unsigned int sz = ward_hdr_read(ptr);
     int b = ward_bucket(sz);
-    if (b >= 0 && ward_bsz[b] == sz) {
+    int exact = b >= 0 && ward_bsz[b] == sz;
+    ward_stat_free(exact ? b : WARD_NBUCKET, sz, ward_hdr_req(ptr));
+#ifdef WARD_THREADS
+    if (exact && b < WARD_TC_CLASSES) {
+        ward_tc_free(b, ptr);
+        return;
+    }
+#endif
+    ward_lock(&ward_heap_lock);
+    if (exact) {
         *(void **)ptr = ward_fl[b];
         ward_fl[b] = ptr;
     } else {
         *(void **)ptr = ward_fl_over;
         ward_fl_over = ptr;
     }
+    ward_unlock(&ward_heap_lock);
 }
 
 void *memset(void *s, int c, unsigned int n) {
@@ -146,10 +473,16 @@ int ward_measure_get(int slot) { return _ward_measure[slot]; }
 #define WARD_MAX_LISTENERS 128
 static void *_ward_listener_table[WARD_MAX_LISTENERS] = {0};
 void ward_listener_set(int id, void *cb) {
-    if (id >= 0 && id < WARD_MAX_LISTENERS) _ward_listener_table[id] = cb;
+    if (id < 0 || id >= WARD_MAX_LISTENERS) return;
+#ifdef WARD_STATS
+    void *old = ward_slot_load(&_ward_listener_table[id]);
+    if (!old && cb) ward_stat_listeners(1);
+    else if (old && !cb) ward_stat_listeners(-1);
+#endif
+    ward_slot_store(&_ward_listener_table[id], cb);
 }
 void *ward_listener_get(int id) {
-    if (id >= 0 && id < WARD_MAX_LISTENERS) return _ward_listener_table[id];
+    if (id >= 0 && id < WARD_MAX_LISTENERS) return ward_slot_load(&_ward_listener_table[id]);
     return (void*)0;
 }
 
@@ -159,8 +492,8 @@ static void *_ward_resolver_table[WARD_MAX_RESOLVERS] = {0};
 
 int ward_resolver_stash(void *resolver) {
     for (int i = 0; i < WARD_MAX_RESOLVERS; i++) {
-        if (!_ward_resolver_table[i]) {
-            _ward_resolver_table[i] = resolver;
+        if (ward_slot_claim(&_ward_resolver_table[i], resolver)) {
+            ward_stat_resolvers(1);
             return i;
         }
     }
@@ -169,16 +502,21 @@ int ward_resolver_stash(void *resolver) {
 
 void *ward_resolver_unstash(int id) {
     if (id < 0 || id >= WARD_MAX_RESOLVERS) return (void*)0;
-    void *r = _ward_resolver_table[id];
-    _ward_resolver_table[id] = 0; /* clear-on-take: linear consumption */
-    return r; /* NULL if already consumed or never stashed */
+    /* clear-on-take: linear consumption */
+    void *r = ward_slot_take(&_ward_resolver_table[id]); /* NULL if already consumed or never stashed */
+    if (r) ward_stat_resolvers(-1);
+    return r;
 }
 
 /* Combined unstash + resolve — safe against bad IDs from JS.
    If ID is invalid or already consumed, silently no-ops. */
 void ward_resolver_fire(int id, int value) {
     void *r = ward_resolver_unstash(id);
-    if (r) _ward_resolve_chain(r, (void*)(long)value);
+    if (r) {
+        int saved = WARD_STAT_CHAIN_BEGIN();
+        _ward_resolve_chain(r, (void*)(long)value);
+        WARD_STAT_CHAIN_END(saved);
+    }
 }
 
 /* Arena block layout: [max:4][used:4][data: max_size bytes] */
@@ -204,3 +542,108 @@ void *ward_arena_alloc(void *arena, int size) {
 void ward_arena_destroy(void *arena) {
     free(arena);
 }
+
+#ifdef WARD_THREADS
+/* --- Single-producer/single-consumer byte ring (threaded build) ---
+ *
+ * Ring layout: [head:4][tail:4][cap:4][pad:4][data: cap bytes]
+ *
+ * head and tail are free-running byte counters; the producer owns head,
+ * the consumer owns tail, and position = counter & (cap - 1) with cap a
+ * power of two. Record layout: [len:4][payload][pad to 4]. A record never
+ * wraps -- if it does not fit before the end, the producer writes
+ * WARD_SPSC_WRAP and skips to offset 0. Each side notifies on the counter
+ * it advances, so the other side can park on it with atomic wait.
+ *
+ * lib/ward_ring.mjs mirrors this layout for the JS ends of the rings.
+ */
+
+#define WARD_SPSC_HEADER 16
+#define WARD_SPSC_WRAP 0xFFFFFFFFu
+
+/* cap is rounded up to a power of two (positions are counter & (cap - 1)) */
+void *ward_spsc_create(int cap) {
+    if (cap <= 0 || cap > (1 << 28)) return (void*)0;
+    unsigned int c = 16;
+    while (c < (unsigned int)cap) c <<= 1;
+    unsigned int *q = (unsigned int *)malloc(WARD_SPSC_HEADER + (int)c);
+    if (!q) return (void*)0;
+    q[2] = c;
+    return q;
+}
+
+int ward_spsc_push(void *ring, const void *src, int len) {
+    unsigned int *q = (unsigned int *)ring;
+    unsigned int cap = q[2];
+    unsigned int need = 4 + (((unsigned int)len + 3u) & ~3u);
+    if (need > cap) return 0;
+    unsigned int head = q[0];
+    unsigned int tail = __atomic_load_n(&q[1], __ATOMIC_ACQUIRE);
+    unsigned int pos = head & (cap - 1);
+    unsigned int skip = (cap - pos < need) ? cap - pos : 0;
+    unsigned char *data = (unsigned char *)ring + WARD_SPSC_HEADER;
+    if ((head - tail) + skip + need > cap) {
+        /* The record cannot go at pos, and the bytes it needs at offset 0
+           are still in use: publish the wrap marker alone so the next push
+           starts at 0. Once the consumer passes it, any need <= cap fits. */
+        if (skip && (head - tail) + skip <= cap) {
+            *(unsigned int *)(data + pos) = WARD_SPSC_WRAP;
+            __atomic_store_n(&q[0], head + skip, __ATOMIC_RELEASE);
+            __builtin_wasm_memory_atomic_notify((int *)&q[0], 1);
+        }
+        return 0;
+    }
+    if (skip) {
+        *(unsigned int *)(data + pos) = WARD_SPSC_WRAP;
+        head += skip;
+        pos = 0;
+    }
+    *(unsigned int *)(data + pos) = (unsigned int)len;
+    memcpy(data + pos + 4, src, (unsigned int)len);
+    __atomic_store_n(&q[0], head + need, __ATOMIC_RELEASE);
+    __builtin_wasm_memory_atomic_notify((int *)&q[0], 1);
+    return 1;
+}
+
+/* Rings between the program worker and the main thread:
+   [0] DOM batches (worker -> main), [1] inbound events (main -> worker).
+   The DOM ring holds several full 256KB diff buffers. */
+#define WARD_DOM_RING_CAP 1048576
+#define WARD_EVENT_RING_CAP 65536
+static void *_ward_mt_rings[2] = { 0, 0 };
+
+void *ward_mt_init(void) {
+    if (!_ward_mt_rings[0]) {
+        /* First call, on the program worker: give it its own TLS block
+           before anything reaches the thread cache */
+        __wasm_init_tls(ward_mt_tls_block());
+        _ward_mt_rings[0] = ward_spsc_create(WARD_DOM_RING_CAP);
+        _ward_mt_rings[1] = ward_spsc_create(WARD_EVENT_RING_CAP);
+    }
+    return _ward_mt_rings;
+}
+
+/* The bridge's ward_dom_flush import, under another C name since runtime.c
+   defines ward_dom_flush itself. In the threaded loader it is an RPC. */
+__attribute__((import_module("env"), import_name("ward_dom_flush")))
+extern void ward_dom_flush_import(void *buf, int len);
+
+/* DOM flush posts the batch to the main-thread applier instead of calling
+   into JS. The stream reuses its buffer as soon as this returns, so the
+   batch is copied into the ring; when the ring is full the worker parks
+   until the main thread advances tail. Before ward_mt_init (or if the ring
+   could not be allocated) nothing is queued yet, so calling the import
+   directly keeps batches in order. */
+void ward_dom_flush(void *buf, int len) {
+    unsigned int *q = (unsigned int *)_ward_mt_rings[0];
+    if (!q) {
+        ward_dom_flush_import(buf, len);
+        return;
+    }
+    for (;;) {
+        unsigned int tail = __atomic_load_n(&q[1], __ATOMIC_ACQUIRE);
+        if (ward_spsc_push(q, buf, len)) return;
+        __builtin_wasm_memory_atomic_wait32((int *)&q[1], (int)tail, -1);
+    }
+}
+#endif
@@ -245,6 +245,7 @@ typedef struct { char _[_ATSTYPE_VAR_SIZE_]; } atstype_var[0];
 #define ward_arr_frozen(...) atstype_ptrk
 #define ward_arr_borrow(...) atstype_ptrk
 #define ward_safe_text(...) atstype_ptrk
+#define ward_tmpl(...) atstype_ptrk
 #define ward_text_builder(...) atstype_ptrk
 #define ward_text_result(...) atstype_ptrk
 #define ward_safe_content_text(...) atstype_ptrk
@@ -326,17 +327,69 @@ static inline void *_ward_cloptr1_wrap(void *f) {
 /* DOM helpers */
 #define ward_dom_state(...) atstype_ptrk
 #define ward_dom_stream(...) atstype_ptrk
+#define ward_dom_span(...) atstype_ptrk
 static inline void ward_set_byte(void *p, int off, int v) {
   ((unsigned char*)p)[off] = (unsigned char)v;
 }
+/* Multi-byte fields are single unaligned little-endian stores: wasm32 is
+   little-endian and __builtin_memcpy of a constant size lowers to one
+   i64.store / i32.store / i32.store16. */
+static inline void ward_set_u16(void *p, int off, int v) {
+  unsigned short x = (unsigned short)v;
+  __builtin_memcpy((unsigned char*)p + off, &x, 2);
+}
 static inline void ward_set_i32(void *p, int off, int v) {
-  unsigned char *d = (unsigned char*)p + off;
-  d[0] = v & 0xFF; d[1] = (v >> 8) & 0xFF;
-  d[2] = (v >> 16) & 0xFF; d[3] = (v >> 24) & 0xFF;
+  __builtin_memcpy((unsigned char*)p + off, &v, 4);
+}
+/* Op header [op][v][ext:3] in one 8-byte store (memory.sats
+   ward_arr_write_op_hdr) */
+static inline void ward_set_op_hdr(void *p, int off, int op, int v, int ext) {
+  unsigned long long x = (unsigned long long)(unsigned char)op
+    | (unsigned long long)(unsigned int)v << 8
+    | (unsigned long long)((unsigned int)ext & 0xFFFFFFu) << 40;
+  __builtin_memcpy((unsigned char*)p + off, &x, 8);
 }
 static inline void ward_copy_at(void *dst, int off, const void *src, int n) {
   memcpy((char*)dst + off, src, n);
 }
+/* Template copy: names are short, so dispatch on the length to a copy of
+   constant size (one or two wide stores); a constant n folds to its case */
+#define WARD_TMPL_CASE(k) case k: __builtin_memcpy(d, src, k); return;
+static inline void ward_copy_tmpl(void *dst, int off, const void *src, int n) {
+  unsigned char *d = (unsigned char*)dst + off;
+  switch (n) {
+  WARD_TMPL_CASE(1) WARD_TMPL_CASE(2) WARD_TMPL_CASE(3) WARD_TMPL_CASE(4)
+  WARD_TMPL_CASE(5) WARD_TMPL_CASE(6) WARD_TMPL_CASE(7) WARD_TMPL_CASE(8)
+  WARD_TMPL_CASE(9) WARD_TMPL_CASE(10) WARD_TMPL_CASE(11) WARD_TMPL_CASE(12)
+  WARD_TMPL_CASE(13) WARD_TMPL_CASE(14) WARD_TMPL_CASE(15) WARD_TMPL_CASE(16)
+  default: memcpy(d, src, n);
+  }
+}
+#undef WARD_TMPL_CASE
+/* Preencoded DOM names (dom.sats ward_dom_name): [len][name bytes] */
+#define ward_dom_name_style() ((void*)"\005style")
+#define ward_dom_tag_div() ((void*)"\003div")
+#define ward_dom_tag_span() ((void*)"\004span")
+#define ward_dom_tag_p() ((void*)"\001p")
+#define ward_dom_tag_a() ((void*)"\001a")
+#define ward_dom_tag_ul() ((void*)"\002ul")
+#define ward_dom_tag_li() ((void*)"\002li")
+#define ward_dom_tag_img() ((void*)"\003img")
+#define ward_dom_tag_button() ((void*)"\006button")
+#define ward_dom_tag_input() ((void*)"\005input")
+#define ward_dom_tag_label() ((void*)"\005label")
+#define ward_dom_tag_section() ((void*)"\007section")
+#define ward_dom_tag_h1() ((void*)"\002h1")
+#define ward_dom_tag_h2() ((void*)"\002h2")
+#define ward_dom_attr_class() ((void*)"\005class")
+#define ward_dom_attr_id() ((void*)"\002id")
+#define ward_dom_attr_type() ((void*)"\004type")
+#define ward_dom_attr_name() ((void*)"\004name")
+#define ward_dom_attr_value() ((void*)"\005value")
+#define ward_dom_attr_href() ((void*)"\004href")
+#define ward_dom_attr_src() ((void*)"\003src")
+#define ward_dom_attr_alt() ((void*)"\003alt")
+#define ward_dom_attr_title() ((void*)"\005title")
 
 /* Resolver stash (implemented in runtime.c) — linear clear-on-take */
 int ward_resolver_stash(void *resolver);
@@ -427,8 +480,52 @@ extern void ward_js_revoke_blob_url(void *url, int url_len);
 /* Callback registry — WASM export, JS calls this to fire callbacks */
 void ward_on_callback(int id, int payload);
 
-/* ward_dom_flush: stub by default, WASM import when WARD_NO_DOM_STUB */
-#ifndef WARD_NO_DOM_STUB
+/* Instrumentation hooks (implemented in runtime.c when WARD_STATS).
+   Without WARD_STATS they expand to nothing. */
+#ifdef WARD_STATS
+void *ward_stats(void);
+void ward_stats_flush(int len);
+int ward_stats_chain_begin(void);
+void ward_stats_chain_step(void);
+void ward_stats_chain_end(int saved);
+#define WARD_STAT_FLUSH(len) ward_stats_flush(len)
+#define WARD_STAT_CHAIN_BEGIN() ward_stats_chain_begin()
+#define WARD_STAT_CHAIN_STEP() ward_stats_chain_step()
+#define WARD_STAT_CHAIN_END(saved) ward_stats_chain_end(saved)
+#else
+#define WARD_STAT_FLUSH(len) ((void)0)
+#define WARD_STAT_CHAIN_BEGIN() 0
+#define WARD_STAT_CHAIN_STEP() ((void)0)
+#define WARD_STAT_CHAIN_END(saved) ((void)(saved))
+#endif
+
+/* Work-stealing fork/join (implemented in ward_par.c) */
+#define ward_par_task(...) atstype_ptrk
+#define ward_par_btask(...) atstype_ptrk
+#define ward_par_half(n) ((n) >> 1)
+#define ward_par_grain() 4096
+void *ward_par_spawn(void *fn, void *arg, int n, int kind);
+int ward_par_wait(void *task);
+void *ward_par_release(void *task);
+void ward_par_start(int nworkers);
+void ward_par_stop(void);
+int ward_par_workers(void);
+#ifdef WARD_THREADS
+void *ward_par_init(int nworkers);
+void ward_par_worker(int id);
+#endif
+
+/* Threaded build (implemented in runtime.c) — SPSC rings shared with the
+   main thread. ward_mt_init returns [dom_ring, event_ring]. */
+#ifdef WARD_THREADS
+void *ward_spsc_create(int cap);
+int ward_spsc_push(void *ring, const void *src, int len);
+void *ward_mt_init(void);
+#endif
+
+/* ward_dom_flush: stub by default, WASM import when WARD_NO_DOM_STUB
+   (defined by runtime.c instead when WARD_THREADS) */
+#if !defined(WARD_NO_DOM_STUB) && !defined(WARD_THREADS)
 static inline void ward_dom_flush(void *buf, int len) {
   /* stub — in WASM, this calls the JS bridge */
 }
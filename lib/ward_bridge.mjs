@@ -7,16 +7,81 @@ function readI32(buf, off) {
   return buf[off] | (buf[off+1] << 8) | (buf[off+2] << 16) | (buf[off+3] << 24);
 }
 
+// Blob URL cache key: MIME type plus the SHA-256 of the blob's bytes.
+// Computed off the flush path (Web Crypto is async); resolves to null
+// where crypto.subtle is unavailable (insecure contexts), which turns
+// the cache off rather than falling back to a weaker key.
+async function blobDigestKey(blob, mime) {
+  const subtle = globalThis.crypto && globalThis.crypto.subtle;
+  if (!subtle) return null;
+  const digest = new Uint8Array(await subtle.digest('SHA-256', await blob.arrayBuffer()));
+  let hex = '';
+  for (let i = 0; i < digest.length; i++) hex += digest[i].toString(16).padStart(2, '0');
+  return mime + '|' + hex;
+}
+
 /**
  * Load a ward WASM module and connect it to a DOM document.
  *
- * @param {BufferSource} wasmBytes — compiled WASM bytes
+ * @param {BufferSource|WebAssembly.Module} wasmBytes — compiled WASM bytes
  * @param {Element} root — root element for ward to render into (node_id 0)
- * @returns {{ exports, nodes, done }} — WASM exports, node registry,
- *   and a promise that resolves when WASM calls ward_exit
+ * @param {object} [opts] — see createWardHost; stats defaults to on when the
+ *   module exports ward_stats (a WARD_STATS build)
+ * @returns {{ exports, nodes, done, stats, trace }} — WASM exports, node
+ *   registry, a promise that resolves when WASM calls ward_exit, and the
+ *   instrumentation readers (both return null when stats are off)
  */
 export async function loadWard(wasmBytes, root, opts) {
+  const module = wasmBytes instanceof WebAssembly.Module
+    ? wasmBytes : await WebAssembly.compile(wasmBytes);
+  const stats = await wardStatsFor(module, opts);
+  const host = createWardHost(root, { ...opts, stats });
+  const instance = await WebAssembly.instantiate(module, host.imports);
+  host.attach(instance, instance.exports.ward_stats ? instance.exports.ward_stats() : 0);
+  const exports = host.exports();
+  exports.ward_node_init(0);
+
+  return {
+    exports, nodes: host.nodes, done: host.done,
+    stats: () => host.stats && host.stats.snapshot(),
+    trace: () => host.stats && host.stats.trace(),
+  };
+}
+
+/**
+ * Stats recorder for a module, or null. On when opts.stats is set, or by
+ * default when the module exports ward_stats. ward_stats.mjs is only loaded
+ * here, so deployments without stats can ship this file on its own.
+ */
+export async function wardStatsFor(module, opts) {
+  const on = opts && opts.stats !== undefined ? opts.stats
+    : WebAssembly.Module.exports(module).some(e => e.name === 'ward_stats');
+  if (!on) return null;
+  if (typeof on === 'object') return on;
+  const { createWardStats } = await import('./ward_stats.mjs');
+  return createWardStats(opts);
+}
+
+/**
+ * Create the host side of the bridge without instantiating anything.
+ * loadWard uses this directly; the threaded loader (ward_threads.mjs)
+ * attaches it to a proxy whose memory is the worker's shared memory.
+ *
+ * @param {Element} root — root element for ward to render into (node_id 0)
+ * @param {object} [opts] — extraImports: merged into env;
+ *   dispatchEvent(listenerId, payload): replaces direct event delivery;
+ *   stats: a recorder from wardStatsFor / createWardStats (ward_stats.mjs)
+ *   that counts crossings and DOM ops and records a trace
+ * @returns {{ imports, nodes, done, attach, exports, stats, stash }} —
+ *   import object, node registry, exit promise, attach(instance, statsPtr)
+ *   to bind the instance whose exports and memory the imports use,
+ *   exports() for the (counted, when stats are on) exports, the stats
+ *   recorder or null, and stash(bytes) -> id for data WASM pulls with
+ *   ward_js_stash_read
+ */
+export function createWardHost(root, opts) {
   const extraImports = (opts && opts.extraImports) || {};
+  const stats = (opts && opts.stats) || null;
   const document = root.ownerDocument;
   let instance = null;
   let resolveDone;
@@ -30,6 +95,17 @@ export async function loadWard(wasmBytes, root, opts) {
     return new Uint8Array(instance.exports.memory.buffer, ptr, len).slice();
   }
 
+  // View into WASM memory without copying. Only valid until WASM runs again,
+  // so use it for consumers that take their own copy synchronously (Blob).
+  // Shared memory cannot be handed to every host API, so it is copied.
+  function viewBytes(ptr, len) {
+    const view = new Uint8Array(instance.exports.memory.buffer, ptr, len);
+    if (typeof SharedArrayBuffer !== 'undefined' && view.buffer instanceof SharedArrayBuffer) {
+      return view.slice();
+    }
+    return view;
+  }
+
   function readString(ptr, len) {
     return new TextDecoder().decode(readBytes(ptr, len));
   }
@@ -54,18 +130,67 @@ export async function loadWard(wasmBytes, root, opts) {
     }
   }
 
-  // Blob URL lifecycle tracking — revoked when element gets new image or is removed
+  // Blob URL lifecycle tracking — node_id -> URL currently shown by that node.
+  // Released when the element gets a new image or is removed.
   const blobUrls = new Map();
 
+  // Image sets whose digest is still being computed: node_id -> token.
+  // A newer set or the node's removal replaces or drops the token, and the
+  // stale result is discarded when it arrives.
+  const pendingImages = new Map();
+
+  // Content-addressed blob URL cache: identical bytes + MIME share one URL.
+  // Keyed by blobDigestKey, so only a SHA-256 collision could alias another
+  // image's URL; entries keep the Blob, never a second copy of the bytes.
+  // Each holder (an image node or a ward_create_blob_url caller) owns one
+  // reference; the URL is revoked when the last reference is released.
+  const blobUrlCache = new Map();   // key -> { key, url, blob, refs }
+  const blobUrlEntries = new Map(); // url -> entry (cached or not)
+
+  // Take a reference to the cached URL for key, or make blob the entry.
+  // A null key gives an entry of its own that is never shared.
+  function acquireBlobUrl(blob, key) {
+    let entry = key ? blobUrlCache.get(key) : null;
+    if (!entry) {
+      entry = { key: null, url: URL.createObjectURL(blob), blob, refs: 0 };
+      blobUrlEntries.set(entry.url, entry);
+      cacheBlobUrl(entry, key);
+    }
+    entry.refs++;
+    return entry;
+  }
+
+  // Publish a live entry under its digest once that is known
+  function cacheBlobUrl(entry, key) {
+    if (!key || entry.key || blobUrlCache.has(key)) return;
+    if (!blobUrlEntries.has(entry.url)) return; // already released
+    entry.key = key;
+    blobUrlCache.set(key, entry);
+  }
+
+  function releaseBlobUrl(url) {
+    const entry = blobUrlEntries.get(url);
+    if (!entry) { URL.revokeObjectURL(url); return; }
+    if (--entry.refs > 0) return;
+    URL.revokeObjectURL(url);
+    blobUrlEntries.delete(url);
+    if (entry.key) blobUrlCache.delete(entry.key);
+  }
+
+  function releaseNodeBlobUrl(nodeId) {
+    pendingImages.delete(nodeId);
+    const oldUrl = blobUrls.get(nodeId);
+    if (oldUrl) { releaseBlobUrl(oldUrl); blobUrls.delete(nodeId); }
+  }
+
   // --- DOM helpers ---
 
-  // Remove all descendant entries from `nodes` and revoke their blob URLs.
+  // Remove all descendant entries from `nodes` and release their blob URLs.
   // Called before clearing or removing an element that may have registered children.
   function cleanDescendants(parentEl) {
     for (const [id, node] of nodes) {
       if (id !== 0 && node !== parentEl && parentEl.contains(node)) {
-        const oldUrl = blobUrls.get(id);
-        if (oldUrl) { URL.revokeObjectURL(oldUrl); blobUrls.delete(id); }
+        releaseNodeBlobUrl(id);
         nodes.delete(id);
       }
     }
@@ -75,10 +200,13 @@ export async function loadWard(wasmBytes, root, opts) {
 
   function wardDomFlush(bufPtr, len) {
     const mem = new Uint8Array(instance.exports.memory.buffer);
+    const t = stats && stats.flushBegin();
     let pos = 0;
+    let opCount = 0;
 
     while (pos < len) {
       const op = mem[bufPtr + pos];
+      const start = pos;
       const nodeId = readI32(mem, bufPtr + pos + 1);
 
       switch (op) {
@@ -127,8 +255,7 @@ export async function loadWard(wasmBytes, root, opts) {
             cleanDescendants(el);
             el.remove();
           }
-          const oldUrl = blobUrls.get(nodeId);
-          if (oldUrl) { URL.revokeObjectURL(oldUrl); blobUrls.delete(nodeId); }
+          releaseNodeBlobUrl(nodeId);
           nodes.delete(nodeId);
           pos += 5;
           break;
@@ -136,21 +263,64 @@ export async function loadWard(wasmBytes, root, opts) {
         default:
           throw new Error(`Unknown ward DOM op: ${op} at offset ${pos}`);
       }
+      if (stats) {
+        stats.recordOp(op, pos - start);
+        opCount++;
+      }
     }
+    if (stats) stats.flushEnd(t, len, opCount);
   }
 
   // --- Image src (direct bridge call, not diff buffer) ---
 
+  // The Blob constructor takes the only synchronous copy, straight out of
+  // WASM memory. The cache lookup waits for the digest, off the flush
+  // path: re-setting an image the node already shows then changes
+  // nothing, and an image shown elsewhere reuses that URL and decode
+  // instead of a new one. <canvas> targets are decoded with
+  // createImageBitmap; <img> targets are marked for async decode.
   function wardJsSetImageSrc(nodeId, dataPtr, dataLen, mimePtr, mimeLen) {
     const mime = readString(mimePtr, mimeLen);
-    const bytes = readBytes(dataPtr, dataLen);
-    const oldUrl = blobUrls.get(nodeId);
-    if (oldUrl) URL.revokeObjectURL(oldUrl);
-    const blob = new Blob([bytes], { type: mime });
-    const url = URL.createObjectURL(blob);
+    const blob = new Blob([viewBytes(dataPtr, dataLen)], { type: mime });
+    const token = {};
+    pendingImages.set(nodeId, token);
+    blobDigestKey(blob, mime).catch(() => null).then((key) => {
+      if (pendingImages.get(nodeId) !== token) return; // superseded or removed
+      pendingImages.delete(nodeId);
+      showImage(nodeId, acquireBlobUrl(blob, key));
+    });
+  }
+
+  function showImage(nodeId, entry) {
+    if (blobUrls.get(nodeId) === entry.url) {
+      entry.refs--; // node already holds a reference to this URL
+      return;
+    }
+    releaseNodeBlobUrl(nodeId);
+    blobUrls.set(nodeId, entry.url);
     const el = nodes.get(nodeId);
-    if (el) el.src = url;
-    blobUrls.set(nodeId, url);
+    if (!el) return;
+    if (el.tagName === 'CANVAS' && typeof createImageBitmap === 'function') {
+      drawImageBitmap(nodeId, el, entry);
+      return;
+    }
+    if ('decoding' in el) el.decoding = 'async';
+    el.src = entry.url;
+  }
+
+  function drawImageBitmap(nodeId, canvas, entry) {
+    createImageBitmap(entry.blob).then((bitmap) => {
+      // A newer image (or node removal) superseded this one while decoding
+      if (blobUrls.get(nodeId) !== entry.url || nodes.get(nodeId) !== canvas) {
+        bitmap.close();
+        return;
+      }
+      canvas.width = bitmap.width;
+      canvas.height = bitmap.height;
+      const ctx = canvas.getContext('2d');
+      if (ctx) ctx.drawImage(bitmap, 0, 0);
+      bitmap.close();
+    }).catch(() => {});
   }
 
   // --- Timer ---
@@ -473,6 +643,15 @@ export async function loadWard(wasmBytes, root, opts) {
   const listenerMap = new Map();
   let currentEvent = null;
 
+  // Deliver an event to WASM: stash the payload, then fire the listener.
+  const dispatchEvent = (opts && opts.dispatchEvent) || function(listenerId, payload) {
+    if (payload) {
+      const stashId = stashData(payload);
+      instance.exports.ward_bridge_stash_set_int(1, stashId);
+    }
+    instance.exports.ward_on_event(listenerId, payload ? payload.length : 0);
+  };
+
   // Encode event payload as binary (little-endian).
   // Returns Uint8Array or null for no payload.
   function encodeEventPayload(event, eventType) {
@@ -564,12 +743,7 @@ export async function loadWard(wasmBytes, root, opts) {
     const eventType = readString(eventTypePtr, typeLen);
     const handler = (event) => {
       currentEvent = event;
-      const payload = encodeEventPayload(event, eventType);
-      if (payload) {
-        const stashId = stashData(payload);
-        instance.exports.ward_bridge_stash_set_int(1, stashId);
-      }
-      instance.exports.ward_on_event(listenerId, payload ? payload.length : 0);
+      dispatchEvent(listenerId, encodeEventPayload(event, eventType));
       currentEvent = null;
     };
     listenerMap.set(listenerId, { node, eventType, handler });
@@ -580,12 +754,7 @@ export async function loadWard(wasmBytes, root, opts) {
     const eventType = readString(eventTypePtr, typeLen);
     const handler = (event) => {
       currentEvent = event;
-      const payload = encodeEventPayload(event, eventType);
-      if (payload) {
-        const stashId = stashData(payload);
-        instance.exports.ward_bridge_stash_set_int(1, stashId);
-      }
-      instance.exports.ward_on_event(listenerId, payload ? payload.length : 0);
+      dispatchEvent(listenerId, encodeEventPayload(event, eventType));
       currentEvent = null;
     };
     listenerMap.set(listenerId, { node: document, eventType, handler });
@@ -913,9 +1082,12 @@ export async function loadWard(wasmBytes, root, opts) {
   function wardJsCreateBlobUrl(dataPtr, dataLen, mimePtr, mimeLen) {
     try {
       const mime = readString(mimePtr, mimeLen);
-      const bytes = readBytes(dataPtr, dataLen);
-      const blob = new Blob([bytes], { type: mime });
-      const url = URL.createObjectURL(blob);
+      // The URL is needed now: it gets an entry of its own, which later
+      // image sets of the same bytes share once its digest is known
+      const blob = new Blob([viewBytes(dataPtr, dataLen)], { type: mime });
+      const entry = acquireBlobUrl(blob, null);
+      blobDigestKey(blob, mime).then((key) => cacheBlobUrl(entry, key), () => {});
+      const { url } = entry;
       const urlBytes = new TextEncoder().encode(url);
       const stashId = stashData(urlBytes);
       instance.exports.ward_bridge_stash_set_int(1, stashId);
@@ -925,8 +1097,7 @@ export async function loadWard(wasmBytes, root, opts) {
 
   function wardJsRevokeBlobUrl(urlPtr, urlLen) {
     try {
-      const url = readString(urlPtr, urlLen);
-      URL.revokeObjectURL(url);
+      releaseBlobUrl(readString(urlPtr, urlLen));
     } catch(e) {}
   }
 
@@ -992,9 +1163,18 @@ export async function loadWard(wasmBytes, root, opts) {
     },
   };
 
-  const result = await WebAssembly.instantiate(wasmBytes, imports);
-  instance = result.instance;
-  instance.exports.ward_node_init(0);
+  if (stats) stats.wrapImports(imports.env);
 
-  return { exports: instance.exports, nodes, done };
+  return {
+    imports,
+    nodes,
+    done,
+    attach(inst, statsPtr) {
+      instance = stats ? stats.wrapInstance(inst) : inst;
+      if (stats && statsPtr) stats.attach(inst.exports.memory, statsPtr);
+    },
+    exports: () => instance.exports,
+    stats,
+    stash: stashData,
+  };
 }
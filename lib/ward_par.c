@@ -0,0 +1,401 @@
+/* ward_par.c -- Work-stealing fork/join scheduler behind par.sats */
+/* One Chase-Lev deque per worker: the owner pushes and pops at the bottom,
+ * idle workers steal from the top. Worker 0 is the thread running the
+ * program; helpers 1..n-1 loop in ward_par_worker.
+ *
+ * Backends (compile time):
+ *   WARD_PAR_PTHREADS -- native gcc build, helpers are pthreads
+ *   WARD_THREADS      -- shared-memory WASM, helpers are extra instances of
+ *                        the module started by ward_worker.mjs
+ *   neither           -- one worker; spawned tasks run when synced
+ */
+
+/* WASM builds get malloc/free from runtime.h (-include); every native
+   build, threaded or not, needs the libc declarations */
+#ifndef __wasm__
+#include <stdlib.h>
+#endif
+
+#ifdef WARD_PAR_PTHREADS
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#define WARD_PAR_MAX_WORKERS 64
+#define WARD_PAR_DEQUE_CAP 1024  /* power of two; full deque runs inline */
+#define WARD_PAR_STACK_SIZE 65536  /* matches -z stack-size */
+#define WARD_PAR_SPARE 64  /* tasks for spawns whose malloc failed */
+
+/* Task kinds — the two body shapes par.sats lets cross into a task */
+#define WARD_PAR_LINEAR 0  /* (ward_arr, n, &res) -> ward_arr */
+#define WARD_PAR_BORROW 1  /* (!ward_arr_borrow, n) -> int */
+
+typedef struct ward_par_task {
+    void *fn;
+    void *arg;
+    int n;
+    int kind;
+    int result;
+    int done;
+} ward_par_task;
+
+/* top and bottom on separate cache lines: thieves hammer top */
+typedef struct {
+    int top;
+    int pad0[15];
+    int bottom;
+    int pad1[15];
+    ward_par_task *buf[WARD_PAR_DEQUE_CAP];
+} ward_par_deque;
+
+static ward_par_deque _ward_par_deques[WARD_PAR_MAX_WORKERS];
+static int _ward_par_nworkers = 1;
+static int _ward_par_running = 0;
+/* Bumped on every push while helpers sleep; helpers park on it */
+static int _ward_par_epoch = 0;
+static int _ward_par_sleepers = 0;
+/* Claimed with an atomic flag by ward_par_spawn, returned by ward_par_release */
+static ward_par_task _ward_par_spare[WARD_PAR_SPARE];
+static int _ward_par_spare_used[WARD_PAR_SPARE];
+
+/* --- Backend: identity, parking, yielding --- */
+
+#if defined(WARD_PAR_PTHREADS)
+static __thread int _ward_par_self_id = 0;
+static pthread_t _ward_par_threads[WARD_PAR_MAX_WORKERS];
+static pthread_mutex_t _ward_par_mu = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _ward_par_cv = PTHREAD_COND_INITIALIZER;
+
+static inline int ward_par_self(void) { return _ward_par_self_id; }
+
+static void ward_par_park(int epoch) {
+    pthread_mutex_lock(&_ward_par_mu);
+    while (__atomic_load_n(&_ward_par_epoch, __ATOMIC_ACQUIRE) == epoch &&
+           __atomic_load_n(&_ward_par_running, __ATOMIC_ACQUIRE))
+        pthread_cond_wait(&_ward_par_cv, &_ward_par_mu);
+    pthread_mutex_unlock(&_ward_par_mu);
+}
+
+static void ward_par_wake_all(void) {
+    pthread_mutex_lock(&_ward_par_mu);
+    pthread_cond_broadcast(&_ward_par_cv);
+    pthread_mutex_unlock(&_ward_par_mu);
+}
+
+static inline void ward_par_yield(int *done) { (void)done; sched_yield(); }
+static inline void ward_par_enter(int id) { (void)id; }
+static inline void ward_par_notify(int *done) { (void)done; }
+
+#elif defined(WARD_THREADS)
+/* Instance-local worker id (helpers are separate instances sharing memory) */
+extern int ward_js_thread_id(void);
+
+static inline int ward_par_self(void) { return ward_js_thread_id(); }
+
+/* Per-helper TLS blocks (runtime.c thread caches), set up by ward_par_init */
+extern void *ward_mt_tls_block(void);
+extern void __wasm_init_tls(void *block);
+static void **_ward_par_tls = 0;
+
+static inline void ward_par_enter(int id) {
+    if (id > 0) __wasm_init_tls(_ward_par_tls[id]);
+}
+
+static void ward_par_park(int epoch) {
+    __builtin_wasm_memory_atomic_wait32(&_ward_par_epoch, epoch, -1);
+}
+
+static void ward_par_wake_all(void) {
+    __builtin_wasm_memory_atomic_notify(&_ward_par_epoch, -1);
+}
+
+/* Nothing to run: sleep on the task's done flag instead of spinning. The
+   timeout bounds the wait so new work from other workers is still picked
+   up; ward_par_notify ends it early when the task finishes. */
+#define WARD_PAR_YIELD_NS 50000LL
+
+static inline void ward_par_yield(int *done) {
+    __builtin_wasm_memory_atomic_wait32(done, 0, WARD_PAR_YIELD_NS);
+}
+
+static inline void ward_par_notify(int *done) {
+    __builtin_wasm_memory_atomic_notify(done, 1);
+}
+
+#else
+static inline int ward_par_self(void) { return 0; }
+static inline void ward_par_enter(int id) { (void)id; }
+static void ward_par_park(int epoch) { (void)epoch; }
+static void ward_par_wake_all(void) {}
+static inline void ward_par_yield(int *done) { (void)done; }
+static inline void ward_par_notify(int *done) { (void)done; }
+#endif
+
+/* --- Deque (Chase-Lev, fixed capacity) --- */
+
+static int ward_par_push(ward_par_deque *d, ward_par_task *t) {
+    int b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED);
+    int top = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+    if (b - top >= WARD_PAR_DEQUE_CAP) return 0;
+    __atomic_store_n(&d->buf[b & (WARD_PAR_DEQUE_CAP - 1)], t, __ATOMIC_RELAXED);
+    __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+static ward_par_task *ward_par_pop(ward_par_deque *d) {
+    int b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&d->bottom, b, __ATOMIC_SEQ_CST);
+    int top = __atomic_load_n(&d->top, __ATOMIC_SEQ_CST);
+    if (top > b) {
+        __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+        return 0;
+    }
+    ward_par_task *t = __atomic_load_n(&d->buf[b & (WARD_PAR_DEQUE_CAP - 1)], __ATOMIC_RELAXED);
+    if (top == b) {
+        /* Last task: race the thieves for it */
+        if (!__atomic_compare_exchange_n(&d->top, &top, top + 1, 0,
+                                         __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+            t = 0;
+        __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+    }
+    return t;
+}
+
+static ward_par_task *ward_par_steal(ward_par_deque *d) {
+    int top = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int b = __atomic_load_n(&d->bottom, __ATOMIC_ACQUIRE);
+    if (top >= b) return 0;
+    ward_par_task *t = __atomic_load_n(&d->buf[top & (WARD_PAR_DEQUE_CAP - 1)], __ATOMIC_RELAXED);
+    if (!__atomic_compare_exchange_n(&d->top, &top, top + 1, 0,
+                                     __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+        return 0;
+    return t;
+}
+
+/* --- Running tasks --- */
+
+static void ward_par_run(ward_par_task *t) {
+    if (t->kind == WARD_PAR_LINEAR) {
+        int res = 0;
+        t->arg = ((void *(*)(void *, int, int *))t->fn)(t->arg, t->n, &res);
+        t->result = res;
+    } else {
+        t->result = ((int (*)(void *, int))t->fn)(t->arg, t->n);
+    }
+    __atomic_store_n(&t->done, 1, __ATOMIC_RELEASE);
+    ward_par_notify(&t->done);
+}
+
+/* Steal one task from any other worker, starting after self */
+static ward_par_task *ward_par_steal_any(int self, unsigned int *seed) {
+    int n = __atomic_load_n(&_ward_par_nworkers, __ATOMIC_ACQUIRE);
+    if (n <= 1) return 0;
+    *seed = *seed * 1103515245u + 12345u;
+    int start = (int)((*seed >> 16) % (unsigned int)n);
+    for (int i = 0; i < n; i++) {
+        int v = (start + i) % n;
+        if (v == self) continue;
+        ward_par_task *t = ward_par_steal(&_ward_par_deques[v]);
+        if (t) return t;
+    }
+    return 0;
+}
+
+/* --- par.sats externs --- */
+
+/* A task for a spawn whose malloc failed, or 0 if the spare pool is empty */
+static ward_par_task *ward_par_spare_task(void) {
+    for (int i = 0; i < WARD_PAR_SPARE; i++) {
+        int expected = 0;
+        if (__atomic_compare_exchange_n(&_ward_par_spare_used[i], &expected, 1, 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            return &_ward_par_spare[i];
+    }
+    return 0;
+}
+
+void *ward_par_spawn(void *fn, void *arg, int n, int kind) {
+    ward_par_task *t = (ward_par_task *)malloc(sizeof(ward_par_task));
+    int inline_run = 0;
+    if (!t) {
+        /* Out of memory: run inline, keeping the result in a spare task */
+        t = ward_par_spare_task();
+        if (!t) __builtin_trap();
+        inline_run = 1;
+    }
+    t->fn = fn;
+    t->arg = arg;
+    t->n = n;
+    t->kind = kind;
+    t->result = 0;
+    t->done = 0;
+    if (inline_run || !ward_par_push(&_ward_par_deques[ward_par_self()], t)) {
+        /* Deque full — plenty of parallel slack already, run inline */
+        ward_par_run(t);
+        return t;
+    }
+    /* Store (bottom) then load (sleepers), mirrored by the helper's
+       increment of sleepers then steal: both sides need seq_cst so at
+       least one of them sees the other's write */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&_ward_par_sleepers, __ATOMIC_SEQ_CST) > 0) {
+        __atomic_fetch_add(&_ward_par_epoch, 1, __ATOMIC_SEQ_CST);
+        ward_par_wake_all();
+    }
+    return t;
+}
+
+/* Block until the task finished, running local or stolen work meanwhile.
+ * Returns the task's int result. */
+int ward_par_wait(void *task) {
+    ward_par_task *t = (ward_par_task *)task;
+    int self = ward_par_self();
+    unsigned int seed = (unsigned int)self * 2654435761u + 1u;
+    while (!__atomic_load_n(&t->done, __ATOMIC_ACQUIRE)) {
+        /* Joins happen in reverse spawn order, so this is usually t itself */
+        ward_par_task *w = ward_par_pop(&_ward_par_deques[self]);
+        if (!w) w = ward_par_steal_any(self, &seed);
+        if (w) ward_par_run(w);
+        else ward_par_yield(&t->done);
+    }
+    return t->result;
+}
+
+/* Free a finished task, returning the array it carried */
+void *ward_par_release(void *task) {
+    ward_par_task *t = (ward_par_task *)task;
+    void *arg = t->arg;
+    if (t >= _ward_par_spare && t < _ward_par_spare + WARD_PAR_SPARE)
+        __atomic_store_n(&_ward_par_spare_used[t - _ward_par_spare], 0, __ATOMIC_RELEASE);
+    else
+        free(t);
+    return arg;
+}
+
+int ward_par_workers(void) {
+    return __atomic_load_n(&_ward_par_nworkers, __ATOMIC_ACQUIRE);
+}
+
+/* Helper loop: run local work, steal, park when the whole pool is dry */
+void ward_par_worker(int id) {
+    unsigned int seed = (unsigned int)id * 2654435761u + 1u;
+    ward_par_enter(id);
+    while (__atomic_load_n(&_ward_par_running, __ATOMIC_ACQUIRE)) {
+        ward_par_task *t = ward_par_pop(&_ward_par_deques[id]);
+        if (!t) t = ward_par_steal_any(id, &seed);
+        if (t) {
+            ward_par_run(t);
+            continue;
+        }
+        int epoch = __atomic_load_n(&_ward_par_epoch, __ATOMIC_SEQ_CST);
+        __atomic_fetch_add(&_ward_par_sleepers, 1, __ATOMIC_SEQ_CST);
+        /* Recheck after announcing: a push before this saw no sleepers */
+        t = ward_par_steal_any(id, &seed);
+        if (t) {
+            __atomic_fetch_sub(&_ward_par_sleepers, 1, __ATOMIC_SEQ_CST);
+            ward_par_run(t);
+            continue;
+        }
+        ward_par_park(epoch);
+        __atomic_fetch_sub(&_ward_par_sleepers, 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+#if defined(WARD_PAR_PTHREADS)
+
+static void *ward_par_thread_main(void *p) {
+    int id = (int)(long)p;
+    _ward_par_self_id = id;
+    ward_par_worker(id);
+    return 0;
+}
+
+void ward_par_start(int nworkers) {
+    if (nworkers > WARD_PAR_MAX_WORKERS) nworkers = WARD_PAR_MAX_WORKERS;
+    if (nworkers < 1) nworkers = 1;
+    if (_ward_par_running) return;
+    __atomic_store_n(&_ward_par_running, 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&_ward_par_nworkers, nworkers, __ATOMIC_RELEASE);
+    for (int i = 1; i < nworkers; i++)
+        pthread_create(&_ward_par_threads[i], 0, ward_par_thread_main, (void *)(long)i);
+}
+
+void ward_par_stop(void) {
+    if (!_ward_par_running) return;
+    __atomic_store_n(&_ward_par_running, 0, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&_ward_par_epoch, 1, __ATOMIC_SEQ_CST);
+    ward_par_wake_all();
+    int n = _ward_par_nworkers;
+    for (int i = 1; i < n; i++)
+        pthread_join(_ward_par_threads[i], 0);
+    __atomic_store_n(&_ward_par_nworkers, 1, __ATOMIC_RELEASE);
+}
+
+int ward_par_cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n < 1 ? 1 : (int)n;
+}
+
+double ward_par_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+#elif defined(WARD_THREADS)
+
+static int *_ward_par_stacks = 0;
+
+/* Called by ward_worker.mjs before starting helpers 1..nworkers-1.
+ * Returns [nworkers] stack tops; helper i sets __stack_pointer to
+ * stacks[i] and then calls ward_par_worker(i), which installs its TLS
+ * block before touching the allocator. If a helper's stack or TLS block
+ * cannot be allocated, the pool stops at the helpers it has and the
+ * remaining entries are 0. Returns 0 (no helpers, the program runs
+ * tasks alone) if the tables themselves cannot be allocated. */
+void *ward_par_init(int nworkers) {
+    if (nworkers > WARD_PAR_MAX_WORKERS) nworkers = WARD_PAR_MAX_WORKERS;
+    if (nworkers < 1) nworkers = 1;
+    int *stacks = (int *)malloc(nworkers * (int)sizeof(int));
+    void **tls = (void **)malloc(nworkers * (int)sizeof(void *));
+    if (!stacks || !tls) {
+        free(stacks);
+        free(tls);
+        return 0;
+    }
+    memset(stacks, 0, nworkers * sizeof(int));
+    tls[0] = 0;
+    int started = 1;
+    while (started < nworkers) {
+        /* malloc blocks are 8-byte aligned; the stack top must be 16 */
+        unsigned char *stack = (unsigned char *)malloc(WARD_PAR_STACK_SIZE + 16);
+        if (!stack) break;
+        void *block = ward_mt_tls_block();
+        if (!block) {
+            free(stack);
+            break;
+        }
+        stacks[started] = (int)(((unsigned long)stack + WARD_PAR_STACK_SIZE + 16) & ~15UL);
+        tls[started] = block;
+        started++;
+    }
+    _ward_par_stacks = stacks;
+    _ward_par_tls = tls;
+    __atomic_store_n(&_ward_par_running, 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&_ward_par_nworkers, started, __ATOMIC_RELEASE);
+    return _ward_par_stacks;
+}
+
+/* Helpers come from the loader; these exist so par.sats is backend-neutral */
+void ward_par_start(int nworkers) { (void)nworkers; }
+void ward_par_stop(void) {}
+
+#else
+
+void ward_par_start(int nworkers) { (void)nworkers; }
+void ward_par_stop(void) {}
+
+#endif
@@ -4,6 +4,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 /* Enable libc malloc/free for ATS2 datavtype constructors */
 #define ATS_MEMALLOC_LIBC
@@ -13,6 +14,7 @@
 #define ward_arr_frozen(...) atstype_ptrk
 #define ward_arr_borrow(...) atstype_ptrk
 #define ward_safe_text(...) atstype_ptrk
+#define ward_tmpl(...) atstype_ptrk
 #define ward_text_builder(...) atstype_ptrk
 #define ward_text_result(...) atstype_ptrk
 #define ward_safe_content_text(...) atstype_ptrk
@@ -24,6 +26,13 @@
 #define ward_promise(...) atstype_ptrk
 #define ward_promise_resolver(...) atstype_ptrk
 
+/* Monotonic clock in milliseconds (native bench driver) */
+static inline double ward_now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
 /* Promise chain resolution (implemented in promise.dats) */
 void _ward_resolve_chain(void *p, void *v);
 
@@ -82,18 +91,77 @@ static inline void *_ward_cloptr1_wrap(void *f) {
 /* DOM helpers */
 #define ward_dom_state(...) atstype_ptrk
 #define ward_dom_stream(...) atstype_ptrk
+#define ward_dom_span(...) atstype_ptrk
 
 static inline void ward_set_byte(void *p, int off, int v) {
   ((unsigned char*)p)[off] = (unsigned char)v;
 }
+/* Same wide stores as runtime.h; byte-swapped on big-endian hosts so the
+   buffer is little-endian everywhere */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define WARD_LE16(v) __builtin_bswap16(v)
+#define WARD_LE32(v) __builtin_bswap32(v)
+#define WARD_LE64(v) __builtin_bswap64(v)
+#else
+#define WARD_LE16(v) (v)
+#define WARD_LE32(v) (v)
+#define WARD_LE64(v) (v)
+#endif
+static inline void ward_set_u16(void *p, int off, int v) {
+  unsigned short x = WARD_LE16((unsigned short)v);
+  __builtin_memcpy((unsigned char*)p + off, &x, 2);
+}
 static inline void ward_set_i32(void *p, int off, int v) {
-  unsigned char *d = (unsigned char*)p + off;
-  d[0] = v & 0xFF; d[1] = (v >> 8) & 0xFF;
-  d[2] = (v >> 16) & 0xFF; d[3] = (v >> 24) & 0xFF;
+  unsigned int x = WARD_LE32((unsigned int)v);
+  __builtin_memcpy((unsigned char*)p + off, &x, 4);
+}
+static inline void ward_set_op_hdr(void *p, int off, int op, int v, int ext) {
+  unsigned long long x = WARD_LE64((unsigned long long)(unsigned char)op
+    | (unsigned long long)(unsigned int)v << 8
+    | (unsigned long long)((unsigned int)ext & 0xFFFFFFu) << 40);
+  __builtin_memcpy((unsigned char*)p + off, &x, 8);
 }
 static inline void ward_copy_at(void *dst, int off, const void *src, int n) {
   memcpy((char*)dst + off, src, n);
 }
+/* Template copy: names are short, so dispatch on the length to a copy of
+   constant size (one or two wide stores); a constant n folds to its case */
+#define WARD_TMPL_CASE(k) case k: __builtin_memcpy(d, src, k); return;
+static inline void ward_copy_tmpl(void *dst, int off, const void *src, int n) {
+  unsigned char *d = (unsigned char*)dst + off;
+  switch (n) {
+  WARD_TMPL_CASE(1) WARD_TMPL_CASE(2) WARD_TMPL_CASE(3) WARD_TMPL_CASE(4)
+  WARD_TMPL_CASE(5) WARD_TMPL_CASE(6) WARD_TMPL_CASE(7) WARD_TMPL_CASE(8)
+  WARD_TMPL_CASE(9) WARD_TMPL_CASE(10) WARD_TMPL_CASE(11) WARD_TMPL_CASE(12)
+  WARD_TMPL_CASE(13) WARD_TMPL_CASE(14) WARD_TMPL_CASE(15) WARD_TMPL_CASE(16)
+  default: memcpy(d, src, n);
+  }
+}
+#undef WARD_TMPL_CASE
+/* Preencoded DOM names (dom.sats ward_dom_name): [len][name bytes] */
+#define ward_dom_name_style() ((void*)"\005style")
+#define ward_dom_tag_div() ((void*)"\003div")
+#define ward_dom_tag_span() ((void*)"\004span")
+#define ward_dom_tag_p() ((void*)"\001p")
+#define ward_dom_tag_a() ((void*)"\001a")
+#define ward_dom_tag_ul() ((void*)"\002ul")
+#define ward_dom_tag_li() ((void*)"\002li")
+#define ward_dom_tag_img() ((void*)"\003img")
+#define ward_dom_tag_button() ((void*)"\006button")
+#define ward_dom_tag_input() ((void*)"\005input")
+#define ward_dom_tag_label() ((void*)"\005label")
+#define ward_dom_tag_section() ((void*)"\007section")
+#define ward_dom_tag_h1() ((void*)"\002h1")
+#define ward_dom_tag_h2() ((void*)"\002h2")
+#define ward_dom_attr_class() ((void*)"\005class")
+#define ward_dom_attr_id() ((void*)"\002id")
+#define ward_dom_attr_type() ((void*)"\004type")
+#define ward_dom_attr_name() ((void*)"\004name")
+#define ward_dom_attr_value() ((void*)"\005value")
+#define ward_dom_attr_href() ((void*)"\004href")
+#define ward_dom_attr_src() ((void*)"\003src")
+#define ward_dom_attr_alt() ((void*)"\003alt")
+#define ward_dom_attr_title() ((void*)"\005title")
 static inline void ward_dom_flush(void *buf, int len) {
   /* stub — in WASM, this calls the JS bridge */
 }
@@ -109,6 +177,9 @@ static inline int ward_bridge_stash_get_int(int slot) { return _ward_bridge_stas
 /* JS data stash stub (native build — no-op) */
 static inline void ward_js_stash_read(int stash_id, void *dest, int len) { /* stub */ }
 
+/* HTML parse stub (native build — no parser, always fails) */
+static inline int ward_js_parse_html(void *html, int html_len) { return 0; }
+
 /* Arena stubs (native build parity with runtime.c) */
 static inline void *ward_arena_create(int max_size) {
     void *p = malloc(max_size + 8);
@@ -163,4 +234,24 @@ static inline void ward_resolver_fire(int id, int value) {
     if (r) _ward_resolve_chain(r, (void*)(long)value);
 }
 
+/* Instrumentation hooks — WASM-only (runtime.c), no-ops natively */
+#define WARD_STAT_FLUSH(len) ((void)0)
+#define WARD_STAT_CHAIN_BEGIN() 0
+#define WARD_STAT_CHAIN_STEP() ((void)0)
+#define WARD_STAT_CHAIN_END(saved) ((void)(saved))
+
+/* Work-stealing fork/join (implemented in ward_par.c) */
+#define ward_par_task(...) atstype_ptrk
+#define ward_par_btask(...) atstype_ptrk
+#define ward_par_half(n) ((n) >> 1)
+#define ward_par_grain() 4096
+void *ward_par_spawn(void *fn, void *arg, int n, int kind);
+int ward_par_wait(void *task);
+void *ward_par_release(void *task);
+void ward_par_start(int nworkers);
+void ward_par_stop(void);
+int ward_par_workers(void);
+int ward_par_cpu_count(void);
+double ward_par_now_ms(void);
+
 #endif /* WARD_PRELUDE_H */
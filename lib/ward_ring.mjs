@@ -0,0 +1,146 @@
+// ward_ring.mjs — JS ends of the runtime.c single-producer/single-consumer rings
+// Used by the threaded build: DOM batches flow worker -> main, events main -> worker.
+//
+// Ring layout (little-endian, inside WASM shared memory):
+//   [head:u32] [tail:u32] [cap:u32] [pad:u32] [data: cap bytes]
+// head/tail are free-running byte counters, position = counter & (cap - 1).
+// Record: [len:u32] [payload] [pad to 4]. A record never wraps; a len of
+// 0xFFFFFFFF means "skip to offset 0". A record that does not fit before
+// the end of the data area while offset 0 is still in use makes the
+// producer publish the skip marker alone and report "full"; once the
+// consumer passes it, any record with size <= cap goes through. Each side
+// notifies on the counter it advances so the other side can park on it.
+
+const HEAD = 0;
+const TAIL = 1;
+const CAP = 2;
+const HEADER = 16;
+const WRAP = 0xFFFFFFFF;
+
+function recordSize(len) {
+  return 4 + ((len + 3) & ~3);
+}
+
+/**
+ * Push one record. Returns false if the ring has no room.
+ *
+ * @param {SharedArrayBuffer} buffer — current WASM memory buffer
+ * @param {number} ring — ring address in WASM memory
+ * @param {Uint8Array} bytes — payload
+ */
+export function ringPush(buffer, ring, bytes) {
+  const h = new Int32Array(buffer, ring, 4);
+  const cap = h[CAP];
+  const need = recordSize(bytes.length);
+  if (need > cap) return false;
+  let head = h[HEAD] >>> 0; // producer-owned
+  const tail = Atomics.load(h, TAIL) >>> 0;
+  let pos = head & (cap - 1);
+  const skip = cap - pos < need ? cap - pos : 0;
+  const used = (head - tail) >>> 0;
+  const dv = new DataView(buffer);
+  const data = ring + HEADER;
+  if (used + skip + need > cap) {
+    // Same as ward_spsc_push: wrap now so the retry starts at offset 0
+    if (skip && used + skip <= cap) {
+      dv.setUint32(data + pos, WRAP, true);
+      Atomics.store(h, HEAD, (head + skip) | 0);
+      Atomics.notify(h, HEAD);
+    }
+    return false;
+  }
+  if (skip) {
+    dv.setUint32(data + pos, WRAP, true);
+    head = (head + skip) >>> 0;
+    pos = 0;
+  }
+  dv.setUint32(data + pos, bytes.length, true);
+  new Uint8Array(buffer, data + pos + 4, bytes.length).set(bytes);
+  Atomics.store(h, HEAD, (head + need) | 0);
+  Atomics.notify(h, HEAD);
+  return true;
+}
+
+/**
+ * Pop every available record, calling fn(ptr, len) with the payload's
+ * address in WASM memory. The payload is only valid during the call.
+ * A record whose fn throws is still consumed: the error goes to
+ * onError(err) and draining continues (without onError it is rethrown
+ * after the ring has moved past the record).
+ * Returns the number of records consumed.
+ */
+export function ringDrain(buffer, ring, fn, onError) {
+  const h = new Int32Array(buffer, ring, 4);
+  const cap = h[CAP];
+  const dv = new DataView(buffer);
+  const data = ring + HEADER;
+  let tail = h[TAIL] >>> 0; // consumer-owned
+  let count = 0;
+  while (tail !== (Atomics.load(h, HEAD) >>> 0)) {
+    const pos = tail & (cap - 1);
+    const len = dv.getUint32(data + pos, true);
+    if (len === WRAP) {
+      tail = (tail + cap - pos) >>> 0;
+    } else {
+      let failed = null;
+      try {
+        fn(data + pos + 4, len);
+      } catch (err) {
+        failed = { err };
+      }
+      tail = (tail + recordSize(len)) >>> 0;
+      count++;
+      if (failed) {
+        Atomics.store(h, TAIL, tail | 0);
+        Atomics.notify(h, TAIL);
+        if (!onError) throw failed.err;
+        onError(failed.err);
+        continue;
+      }
+    }
+    // Release space per record so a parked producer resumes early
+    Atomics.store(h, TAIL, tail | 0);
+    Atomics.notify(h, TAIL);
+  }
+  return count;
+}
+
+/**
+ * Drain a ring whenever its producer advances head, without blocking the
+ * calling thread (Atomics.waitAsync; polling where it is unavailable).
+ *
+ * @param {WebAssembly.Memory} memory — shared WASM memory
+ * @param {number} ring — ring address in WASM memory
+ * @param {function(number, number)} fn — record callback, as in ringDrain
+ * @param {function(Error)} onError — called when fn throws; the record is
+ *   skipped and watching continues
+ * @returns {{ drain, stop }} — drain now; stop watching
+ */
+export function ringWatch(memory, ring, fn, onError) {
+  let stopped = false;
+  const drain = () => ringDrain(memory.buffer, ring, fn, onError);
+
+  function loop() {
+    if (stopped) return;
+    drain();
+    const h = new Int32Array(memory.buffer, ring, 4);
+    // Everything up to head was consumed, so tail == head unless more arrived
+    const seen = Atomics.load(h, TAIL);
+    if (typeof Atomics.waitAsync !== 'function') {
+      setTimeout(loop, 4);
+      return;
+    }
+    const r = Atomics.waitAsync(h, HEAD, seen);
+    if (r.async) r.value.then(loop);
+    else Promise.resolve().then(loop);
+  }
+  loop();
+
+  return {
+    drain,
+    stop() {
+      stopped = true;
+      Atomics.notify(new Int32Array(memory.buffer, ring, 4), HEAD);
+    },
+  };
+}
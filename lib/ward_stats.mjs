@@ -0,0 +1,177 @@
+// ward_stats.mjs — Bridge-side instrumentation and Chrome trace export
+// Loaded on demand by ward_bridge.mjs (wardStatsFor): on with { stats: true },
+// or by default when the module exports ward_stats (a -DWARD_STATS build).
+// Counts WASM<->JS crossings per import/export and DOM ops per opcode,
+// decodes the runtime.c counters, and records trace events loadable in
+// chrome://tracing or Perfetto.
+
+// runtime.c ward_stats_t, in field order (i32 each; arrays expand in place)
+const WASM_FIELDS = [
+  ['version', 1], ['nfields', 1],
+  ['alloc_count', 10], ['free_count', 10],
+  ['live_bytes', 1], ['live_requested', 1], ['peak_bytes', 1],
+  ['heap_bytes', 1], ['free_list_bytes', 1],
+  ['flush_count', 1], ['flush_bytes', 1], ['flush_max', 1],
+  ['resolvers_live', 1], ['resolvers_peak', 1],
+  ['listeners_live', 1], ['listeners_peak', 1],
+  ['chain_resolves', 1], ['chain_max_depth', 1], ['chain_depth_hist', 6],
+];
+
+// Size classes behind alloc_count/free_count (runtime.c buckets + oversized)
+export const ALLOC_CLASSES = [
+  '32', '128', '512', '4096', '8192', '16384', '65536', '262144', '1048576', 'oversized',
+];
+export const CHAIN_DEPTHS = ['1', '2', '3-4', '5-8', '9-16', '17+'];
+
+const OP_NAMES = {
+  1: 'SET_TEXT', 2: 'SET_ATTR', 3: 'REMOVE_CHILDREN', 4: 'CREATE_ELEMENT', 5: 'REMOVE_CHILD',
+};
+
+const now = () => (typeof performance !== 'undefined' ? performance.now() : Date.now());
+
+/**
+ * Decode the runtime.c counters at ptr.
+ * @returns {object|null} — null if ptr is 0
+ */
+export function readWasmStats(buffer, ptr) {
+  if (!ptr) return null;
+  const v = new Int32Array(buffer, ptr, 2);
+  const words = new Int32Array(buffer, ptr, v[1]);
+  const out = {};
+  let i = 0;
+  for (const [name, n] of WASM_FIELDS) {
+    out[name] = n === 1 ? words[i] : Array.from(words.subarray(i, i + n));
+    i += n;
+  }
+  out.internal_fragmentation = out.live_bytes - out.live_requested;
+  return out;
+}
+
+/**
+ * @param {object} [opts] — traceLimit: max trace events kept (default 100000)
+ */
+export function createWardStats(opts) {
+  const traceLimit = (opts && opts.traceLimit) || 100000;
+  const imports = Object.create(null);
+  const exports = Object.create(null);
+  const ops = Object.create(null);
+  const dom = { flushes: 0, bytes: 0, maxBytes: 0, ops };
+  const events = [];
+  let dropped = 0;
+  let memory = null;
+  let statsPtr = 0;
+  const t0 = now();
+
+  function emit(ev) {
+    if (events.length < traceLimit) events.push(ev);
+    else dropped++;
+  }
+
+  function span(name, cat, start, args) {
+    const end = now();
+    emit({
+      name, cat, ph: 'X', pid: 1, tid: 1,
+      ts: Math.round((start - t0) * 1000), dur: Math.round((end - start) * 1000), args,
+    });
+  }
+
+  function counters() {
+    const w = memory && readWasmStats(memory.buffer, statsPtr);
+    if (!w) return;
+    emit({
+      name: 'heap', cat: 'wasm', ph: 'C', pid: 1, tid: 1,
+      ts: Math.round((now() - t0) * 1000),
+      args: { live: w.live_bytes, free_lists: w.free_list_bytes, heap: w.heap_bytes },
+    });
+  }
+
+  return {
+    // Count and time every host import. The flush import gets its own
+    // span with op/byte totals (see flushBegin/flushEnd).
+    wrapImports(env) {
+      for (const name of Object.keys(env)) {
+        const f = env[name];
+        if (typeof f !== 'function' || name === 'ward_dom_flush') continue;
+        imports[name] = 0;
+        env[name] = function (...args) {
+          imports[name]++;
+          const start = now();
+          try {
+            return f.apply(this, args);
+          } finally {
+            span(name, 'import', start);
+          }
+        };
+      }
+      return env;
+    },
+
+    // Wrap an instance so calls through instance.exports are counted
+    wrapInstance(inst) {
+      const proxy = new Proxy(inst.exports, {
+        get(target, name) {
+          const v = target[name];
+          if (typeof v !== 'function' || typeof name !== 'string') return v;
+          return (...args) => {
+            exports[name] = (exports[name] || 0) + 1;
+            const start = now();
+            try {
+              return v(...args);
+            } finally {
+              span(name, 'export', start);
+            }
+          };
+        },
+      });
+      return { exports: proxy };
+    },
+
+    // Where the runtime.c counters live (0 if the build has none)
+    attach(mem, ptr) {
+      memory = mem;
+      statsPtr = ptr | 0;
+    },
+
+    flushBegin() {
+      imports.ward_dom_flush = (imports.ward_dom_flush || 0) + 1;
+      return now();
+    },
+
+    recordOp(op, bytes) {
+      const name = OP_NAMES[op] || String(op);
+      const o = ops[name] || (ops[name] = { count: 0, bytes: 0 });
+      o.count++;
+      o.bytes += bytes;
+    },
+
+    flushEnd(start, len, opCount) {
+      dom.flushes++;
+      dom.bytes += len;
+      if (len > dom.maxBytes) dom.maxBytes = len;
+      span('ward_dom_flush', 'dom', start, { bytes: len, ops: opCount });
+      counters();
+    },
+
+    // Plain-object snapshot of every counter
+    snapshot() {
+      return {
+        wasm: memory ? readWasmStats(memory.buffer, statsPtr) : null,
+        dom: { ...dom, ops: structuredClone(ops) },
+        crossings: { imports: { ...imports }, exports: { ...exports } },
+        trace: { events: events.length, dropped },
+      };
+    },
+
+    // Chrome trace-event JSON (object form)
+    trace() {
+      return {
+        traceEvents: [
+          { name: 'process_name', ph: 'M', pid: 1, tid: 1, args: { name: 'ward' } },
+          ...events,
+        ],
+        displayTimeUnit: 'ms',
+        otherData: { dropped },
+      };
+    },
+  };
+}
@@ -0,0 +1,250 @@
+// ward_threads.mjs — Threaded loader: ward WASM in a worker, DOM on the main thread
+// The worker (ward_worker.mjs) instantiates a shared-memory build
+// (node_ward_mt.wasm). This thread stays a thin applier:
+//   - DOM batches arrive on the runtime.c DOM ring and are applied by the
+//     same decoder loadWard uses (ward_dom_flush reads the shared memory).
+//   - Other host imports are synchronous RPCs: the worker parks on the rpc
+//     control word while this thread runs the import against shared memory.
+//   - DOM events are pushed onto the event ring for the worker to drain.
+//     A record is [listener_id:i32] [stash_id:i32] [payload]; payloads over
+//     half the ring stay in this thread's stash (stash_id >= 0, the record
+//     then carries only [len:i32]) and WASM reads them with the
+//     ward_js_stash_read RPC, so every event fits the ring and keeps its
+//     place in order.
+// Works in browsers (module Worker) and Node.js (worker_threads).
+
+import { createWardHost, wardStatsFor } from './ward_bridge.mjs';
+import { ringPush, ringWatch } from './ward_ring.mjs';
+
+// RPC control block (SharedArrayBuffer, shared with ward_worker.mjs):
+//   [state:i32] [kind:i32] [log_len:i32] [pad:i32] [ret:f64|i64] [log: JSON bytes]
+// The return value is stored untruncated: kind RPC_RET_NUMBER is an f64
+// (i32 and f64 imports both round-trip through it), RPC_RET_BIGINT an i64.
+// The log carries export calls the import made (e.g. ward_measure_set)
+// so the worker replays them before returning to WASM.
+export const RPC_IDLE = 0;
+export const RPC_DONE = 1;
+export const RPC_RET = 16;
+export const RPC_LOG = 24;
+export const RPC_SIZE = 65536;
+export const RPC_RET_NUMBER = 0;
+export const RPC_RET_BIGINT = 1;
+
+// Shared memory limits — must match the threaded link flags in the Makefile
+export const MT_INITIAL_PAGES = 256;
+export const MT_MAXIMUM_PAGES = 4096;
+
+async function defaultCreateWorker(url) {
+  if (typeof Worker === 'function') {
+    const w = new Worker(url, { type: 'module' });
+    return {
+      post: (msg) => w.postMessage(msg),
+      onMessage: (fn) => w.addEventListener('message', (e) => fn(e.data)),
+      terminate: () => w.terminate(),
+    };
+  }
+  const { Worker: NodeWorker } = await import('node:worker_threads');
+  const w = new NodeWorker(url);
+  return {
+    post: (msg) => w.postMessage(msg),
+    onMessage: (fn) => w.on('message', fn),
+    terminate: () => w.terminate(),
+  };
+}
+
+/**
+ * Load a threaded ward WASM build in a worker and connect it to a DOM document.
+ *
+ * @param {BufferSource|WebAssembly.Module} wasm — threaded build (node_ward_mt.wasm)
+ * @param {Element} root — root element for ward to render into (node_id 0)
+ * @param {object} [opts] — createWorker(url): custom worker factory returning
+ *   { post, onMessage, terminate }; threads: ward_par workers including the
+ *   program's own (default 1, no helpers); onError(err): receives failures
+ *   after startup, such as a trap in an event handler (default reportError
+ *   or console.error); other options go to createWardHost
+ *   (stats defaults to on when the module exports ward_stats)
+ * @returns {Promise<{ nodes, done, terminate, stats, trace }>} — node
+ *   registry, a promise that resolves when WASM calls ward_exit, a function
+ *   to stop the worker, and the instrumentation readers (as in loadWard)
+ */
+export async function loadWardThreaded(wasm, root, opts) {
+  const createWorker = (opts && opts.createWorker) || defaultCreateWorker;
+  const module = wasm instanceof WebAssembly.Module ? wasm : await WebAssembly.compile(wasm);
+  const stats = await wardStatsFor(module, opts);
+  const memory = new WebAssembly.Memory({
+    initial: MT_INITIAL_PAGES, maximum: MT_MAXIMUM_PAGES, shared: true,
+  });
+  const rpc = new SharedArrayBuffer(RPC_SIZE);
+  const ctl = new Int32Array(rpc, 0, 4);
+  const worker = await createWorker(new URL('./ward_worker.mjs', import.meta.url));
+
+  // Export calls made by the host: recorded while an RPC is being served,
+  // otherwise gathered for the rest of the current host turn and posted as
+  // one message. Async completions make several calls that belong together
+  // (stash slot, then the fire export); the worker replays a batch without
+  // yielding, so no event delivery can run in between.
+  let rpcLog = null;
+  let callBatch = null;
+  function forward(name, args) {
+    if (rpcLog) {
+      rpcLog.push([name, args]);
+      return;
+    }
+    if (!callBatch) {
+      callBatch = [];
+      queueMicrotask(() => {
+        const calls = callBatch;
+        callBatch = null;
+        if (!stopped) worker.post({ type: 'calls', calls });
+      });
+    }
+    callBatch.push([name, args]);
+  }
+  const exports = new Proxy({ memory }, {
+    get(target, name) {
+      if (name in target || typeof name !== 'string') return target[name];
+      return (...args) => forward(name, args);
+    },
+  });
+
+  let rings = null;   // [dom_ring, event_ring] from ward_mt_init
+  let domWatch = null;
+  let stopped = false;
+
+  // Events go through the event ring in dispatch order. Records that do
+  // not fit (ring full, or not created yet) wait here, and later events
+  // queue behind them until the worker has made room.
+  // ward_prevent_default is rejected in threaded mode (ward_worker.mjs):
+  // the worker sees events after dispatch has finished.
+  const pendingEvents = [];   // { listenerId, payload, rec }
+  let retryTimer = null;
+
+  // Built on first push, once the ring (and its capacity) is known
+  function eventRecord(ev) {
+    if (ev.rec) return ev.rec;
+    const len = ev.payload ? ev.payload.length : 0;
+    const cap = new Int32Array(memory.buffer, rings[1], 4)[2];
+    const inline = 4 + 8 + len <= cap / 2;
+    const rec = new Uint8Array(8 + (inline ? len : 4));
+    const dv = new DataView(rec.buffer);
+    dv.setInt32(0, ev.listenerId, true);
+    if (inline) {
+      dv.setInt32(4, -1, true);
+      if (len) rec.set(ev.payload, 8);
+    } else {
+      dv.setInt32(4, host.stash(ev.payload), true);
+      dv.setInt32(8, len, true);
+    }
+    ev.payload = null;
+    return ev.rec = rec;
+  }
+
+  function flushEvents() {
+    retryTimer = null;
+    if (!rings || !rings[1]) return;   // 'ready' flushes
+    while (pendingEvents.length > 0) {
+      if (!ringPush(memory.buffer, rings[1], eventRecord(pendingEvents[0]))) break;
+      pendingEvents.shift();
+    }
+    if (pendingEvents.length > 0 && !stopped) retryTimer = setTimeout(flushEvents, 1);
+  }
+
+  function queueEvent(listenerId, payload) {
+    pendingEvents.push({ listenerId, payload, rec: null });
+    if (!retryTimer) flushEvents();
+  }
+
+  const host = createWardHost(root, { ...opts, stats, dispatchEvent: queueEvent });
+  host.attach({ exports });
+  const env = host.imports.env;
+  const flushRecord = (ptr, len) => env.ward_dom_flush(ptr, len);
+
+  // Failures after startup (a trap in an event handler, a bad DOM batch)
+  // fail that one delivery, as an exception out of a listener does in
+  // loadWard; they are reported and the program keeps running
+  const report = (opts && opts.onError) || ((err) => {
+    if (typeof reportError === 'function') reportError(err);
+    else console.error(err);
+  });
+
+  function terminate() {
+    if (stopped) return;
+    stopped = true;
+    if (retryTimer) clearTimeout(retryTimer);
+    if (domWatch) domWatch.stop();
+    worker.terminate();
+  }
+
+  const retView = new DataView(rpc, RPC_RET, 8);
+
+  function serveRpc(name, args) {
+    rpcLog = [];
+    let ret = 0;
+    try {
+      ret = env[name](...args);
+    } finally {
+      const log = new TextEncoder().encode(JSON.stringify(rpcLog));
+      rpcLog = null;
+      if (log.length > RPC_SIZE - RPC_LOG) {
+        throw new Error(`ward rpc ${name}: reply log too large (${log.length} bytes)`);
+      }
+      new Uint8Array(rpc, RPC_LOG, log.length).set(log);
+      if (typeof ret === 'bigint') {
+        ctl[1] = RPC_RET_BIGINT;
+        retView.setBigInt64(0, ret, true);
+      } else {
+        ctl[1] = RPC_RET_NUMBER;
+        retView.setFloat64(0, ret === undefined ? 0 : Number(ret), true);
+      }
+      ctl[2] = log.length;
+      Atomics.store(ctl, 0, RPC_DONE);
+      Atomics.notify(ctl, 0);
+    }
+  }
+
+  let resolveReady, rejectReady;
+  let isReady = false;
+  const ready = new Promise((res, rej) => { resolveReady = res; rejectReady = rej; });
+
+  worker.onMessage((msg) => {
+    // DOM batches queued before this message must land first
+    if (domWatch) domWatch.drain();
+    switch (msg.type) {
+      case 'ready':
+        rings = msg.rings;
+        if (host.stats && msg.statsPtr) host.stats.attach(memory, msg.statsPtr);
+        // A ring that failed to allocate is 0: the worker then flushes DOM
+        // batches through the ward_dom_flush RPC instead
+        if (rings[0]) domWatch = ringWatch(memory, rings[0], flushRecord, report);
+        isReady = true;
+        flushEvents();
+        resolveReady();
+        break;
+      case 'rpc':
+        serveRpc(msg.name, msg.args);
+        break;
+      case 'exit':
+        env.ward_exit();
+        terminate();
+        break;
+      case 'error':
+        if (isReady) {
+          report(new Error(msg.message));
+          break;
+        }
+        rejectReady(new Error(msg.message));
+        terminate();
+        break;
+    }
+  });
+
+  const threads = (opts && opts.threads) || 1;
+  worker.post({ type: 'init', wasm: module, memory, rpc, threads });
+  await ready;
+
+  return {
+    nodes: host.nodes, done: host.done, terminate,
+    stats: () => host.stats && host.stats.snapshot(),
+    trace: () => host.stats && host.stats.trace(),
+  };
+}
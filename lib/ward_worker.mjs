@@ -0,0 +1,187 @@
+// ward_worker.mjs — Worker side of the threaded loader (see ward_threads.mjs)
+// Instantiates a shared-memory ward build and runs the program off the main
+// thread. Timers and the event ring are served here; every other host import
+// is a synchronous RPC to the main thread, which reads and writes the shared
+// memory directly while this worker is parked.
+//
+// The same file also runs ward_par helpers ({type:'par'}): further instances
+// of the module on the shared memory that only execute stolen tasks.
+
+import { ringWatch } from './ward_ring.mjs';
+
+// RPC control block layout — must match ward_threads.mjs
+const RPC_IDLE = 0;
+const RPC_RET = 16;
+const RPC_LOG = 24;
+const RPC_RET_BIGINT = 1;
+const WARD_PAR_MAX_WORKERS = 64; // ward_par.c
+
+let port = null;
+let NodeWorker = null;
+try {
+  const wt = await import('node:worker_threads');
+  NodeWorker = wt.Worker;
+  if (wt.parentPort) {
+    port = {
+      post: (msg) => wt.parentPort.postMessage(msg),
+      onMessage: (fn) => wt.parentPort.on('message', fn),
+    };
+  }
+} catch (e) {}
+if (!port) {
+  port = {
+    post: (msg) => self.postMessage(msg),
+    onMessage: (fn) => self.addEventListener('message', (e) => fn(e.data)),
+  };
+}
+
+let instance = null;
+
+// Worker-local stash for event payloads drained from the ring. Negative IDs
+// keep it disjoint from the main thread's stash (IDs >= 0).
+const localStash = new Map();
+let nextLocalStashId = -1;
+
+// Event ring record: [listener_id:i32] [stash_id:i32] [payload]. stash_id
+// -1: the payload follows inline. Otherwise the payload was too large for
+// the ring and sits in the main thread's stash; the record holds [len:i32]
+// and WASM's ward_js_stash_read fetches it by RPC.
+function deliverEvent(rec) {
+  const dv = new DataView(rec.buffer, rec.byteOffset, rec.byteLength);
+  const listenerId = dv.getInt32(0, true);
+  let stashId = dv.getInt32(4, true);
+  let len;
+  if (stashId === -1) {
+    len = rec.length - 8;
+    if (len > 0) {
+      stashId = nextLocalStashId--;
+      localStash.set(stashId, rec.subarray(8));
+    }
+  } else {
+    len = dv.getInt32(8, true);
+  }
+  if (len > 0) instance.exports.ward_bridge_stash_set_int(1, stashId);
+  instance.exports.ward_on_event(listenerId, len);
+}
+
+// Start ward_par helper i on its own stack (allocated by ward_par_init)
+function startHelper(module, memory, id, stack) {
+  const url = new URL(import.meta.url);
+  const w = NodeWorker ? new NodeWorker(url) : new Worker(url, { type: 'module' });
+  w.postMessage({ type: 'par', module, memory, id, stack });
+  return w;
+}
+
+// Helper body: no host access, only ward_js_thread_id. Never returns
+// while the pool is running.
+async function runHelper({ module, memory, id, stack }) {
+  const env = { memory };
+  for (const imp of WebAssembly.Module.imports(module)) {
+    if (imp.module !== 'env' || imp.kind !== 'function') continue;
+    env[imp.name] = () => {
+      throw new Error(`ward_par: ${imp.name} called from a parallel task`);
+    };
+  }
+  env.ward_js_thread_id = () => id;
+  const helper = await WebAssembly.instantiate(module, { env });
+  helper.exports.__stack_pointer.value = stack;
+  helper.exports.ward_par_worker(id);
+}
+
+async function init({ wasm, memory, rpc, threads }) {
+  const ctl = new Int32Array(rpc, 0, 4);
+  const retView = new DataView(rpc, RPC_RET, 8);
+
+  function rpcCall(name, ...args) {
+    port.post({ type: 'rpc', name, args });
+    Atomics.wait(ctl, 0, RPC_IDLE);
+    // Typed slot: WASM converts the number back per the import's signature
+    const ret = ctl[1] === RPC_RET_BIGINT
+      ? retView.getBigInt64(0, true) : retView.getFloat64(0, true);
+    const logLen = ctl[2];
+    // TextDecoder rejects shared views — copy first
+    const log = JSON.parse(new TextDecoder().decode(
+      new Uint8Array(rpc, RPC_LOG, logLen).slice()));
+    Atomics.store(ctl, 0, RPC_IDLE);
+    for (const [fn, fnArgs] of log) instance.exports[fn](...fnArgs);
+    return ret;
+  }
+
+  const local = {
+    ward_set_timer(delayMs, resolverId) {
+      setTimeout(() => {
+        instance.exports.ward_timer_fire(resolverId);
+      }, delayMs);
+    },
+    ward_exit() {
+      port.post({ type: 'exit' });
+    },
+    ward_js_thread_id() {
+      return 0;
+    },
+    // The main thread dispatched the event before this worker sees it, so
+    // there is nothing left to prevent. Trap rather than silently ignore.
+    ward_js_prevent_default() {
+      throw new Error('ward_prevent_default is not supported in threaded mode ' +
+        '(events reach the worker after dispatch); use loadWard for listeners that need it');
+    },
+    ward_js_stash_read(stashId, destPtr, len) {
+      if (stashId >= 0) return rpcCall('ward_js_stash_read', stashId, destPtr, len);
+      const data = localStash.get(stashId);
+      if (data) {
+        const copyLen = Math.min(len, data.length);
+        new Uint8Array(memory.buffer).set(data.subarray(0, copyLen), destPtr);
+        localStash.delete(stashId);
+      }
+    },
+  };
+
+  const module = wasm instanceof WebAssembly.Module ? wasm : await WebAssembly.compile(wasm);
+  const env = { memory };
+  for (const imp of WebAssembly.Module.imports(module)) {
+    if (imp.module !== 'env' || imp.kind !== 'function') continue;
+    env[imp.name] = local[imp.name] || ((...args) => rpcCall(imp.name, ...args));
+  }
+  instance = await WebAssembly.instantiate(module, { env });
+
+  const ringsPtr = instance.exports.ward_mt_init();
+  const view = new Uint32Array(memory.buffer, ringsPtr, 2);
+  const rings = [view[0], view[1]];
+  // A trap in one handler fails that event only: the ring moves past it
+  // and the main thread reports the error
+  if (rings[1]) ringWatch(memory, rings[1], (ptr, len) => {
+    deliverEvent(new Uint8Array(memory.buffer, ptr, len).slice());
+  }, (err) => port.post({ type: 'error', message: String(err && err.stack || err) }));
+
+  if (threads > 1 && instance.exports.ward_par_init) {
+    threads = Math.min(threads, WARD_PAR_MAX_WORKERS);
+    // 0: no memory for the worker tables, tasks run on this worker alone.
+    // A 0 stack ends the helpers that could be allocated.
+    const stacksPtr = instance.exports.ward_par_init(threads);
+    const stacks = stacksPtr ? new Uint32Array(memory.buffer, stacksPtr, threads).slice() : [];
+    for (let i = 1; i < stacks.length && stacks[i]; i++) startHelper(module, memory, i, stacks[i]);
+  }
+
+  const statsPtr = instance.exports.ward_stats ? instance.exports.ward_stats() : 0;
+  port.post({ type: 'ready', rings, statsPtr });
+  instance.exports.ward_node_init(0);
+}
+
+port.onMessage((msg) => {
+  switch (msg.type) {
+    case 'init':
+      init(msg).catch((err) => port.post({ type: 'error', message: String(err && err.stack || err) }));
+      break;
+    case 'par':
+      runHelper(msg).catch((err) => console.error(err));
+      break;
+    case 'calls':
+      // One host turn's export calls, replayed back to back
+      try {
+        for (const [name, args] of msg.calls) instance.exports[name](...args);
+      } catch (err) {
+        port.post({ type: 'error', message: String(err && err.stack || err) });
+      }
+      break;
+  }
+});
@@ -32,4 +32,17 @@ describe('DOM operations', () => {
     assert.ok(span, 'expected <span> element');
     assert.equal(span.getAttribute('class'), 'demo');
   });
+
+  it('applies ops written through a reserved span', async () => {
+    const { root } = await createWardInstance();
+
+    // Wait for 1s timer to fire + some margin
+    await new Promise(r => setTimeout(r, 1500));
+
+    // Preencoded <button> tag and class name, one reservation
+    const button = root.querySelector('button');
+    assert.ok(button, 'expected <button> element');
+    assert.equal(button.getAttribute('class'), 'go');
+    assert.equal(button.textContent, 'go');
+  });
 });
@@ -3,6 +3,26 @@
 import { describe, it } from 'node:test';
 import assert from 'node:assert/strict';
 import { createWardInstance } from './helpers.mjs';
+import { createWardHost } from './../lib/ward_bridge.mjs';
+
+// A host wired to a bare memory, so image imports can be driven directly.
+// Nodes 1-3 are plain objects that record the src they are given.
+function blobHost() {
+  const memory = new WebAssembly.Memory({ initial: 1 });
+  const host = createWardHost({ ownerDocument: {} });
+  host.attach({ exports: { memory, ward_bridge_stash_set_int() {} } });
+  for (const id of [1, 2, 3]) host.nodes.set(id, {});
+  const mem = new Uint8Array(memory.buffer);
+  const mime = new TextEncoder().encode('image/png');
+  mem.set(mime, 0);
+  return { mem, env: host.imports.env, nodes: host.nodes, mimeLen: mime.length };
+}
+
+// The cache lookup runs once the async digest is done
+async function until(cond) {
+  for (let i = 0; i < 100 && !cond(); i++) await new Promise(r => setTimeout(r, 5));
+  assert.ok(cond(), 'timed out waiting for image sets to settle');
+}
 
 describe('Image display', () => {
   it('sets blob URL on img element after timer fires', async () => {
@@ -16,4 +36,55 @@ describe('Image display', () => {
     assert.ok(img.src, 'expected src attribute on <img>');
     assert.ok(img.src.startsWith('blob:'), `expected blob: URL, got ${img.src}`);
   });
+
+  it('reuses the cached blob URL when the same bytes are set again', async () => {
+    const created = [];
+    const revoked = [];
+    const origCreate = URL.createObjectURL;
+    const origRevoke = URL.revokeObjectURL;
+    URL.createObjectURL = (blob) => { const u = origCreate(blob); created.push(u); return u; };
+    URL.revokeObjectURL = (url) => { revoked.push(url); origRevoke(url); };
+    try {
+      const { root } = await createWardInstance();
+
+      // Wait for 1s timer to fire + some margin
+      await new Promise(r => setTimeout(r, 1500));
+
+      // The exerciser sets identical image bytes on node 4 twice
+      const img = root.querySelector('img');
+      assert.ok(img, 'expected <img> element');
+      assert.equal(created.length, 1, 'expected a single blob URL for identical bytes');
+      assert.equal(img.src, created[0]);
+      assert.equal(revoked.length, 0, 'cached URL must not be revoked while shown');
+    } finally {
+      URL.createObjectURL = origCreate;
+      URL.revokeObjectURL = origRevoke;
+    }
+  });
+
+  it('shares a URL only between identical bytes', async () => {
+    const created = [];
+    const origCreate = URL.createObjectURL;
+    URL.createObjectURL = (blob) => { const u = origCreate(blob); created.push(u); return u; };
+    try {
+      const { mem, env, nodes, mimeLen } = blobHost();
+      // Two 4096-byte images that differ in one byte in the middle
+      mem.fill(7, 1024, 1024 + 4096);
+      mem.fill(7, 8192, 8192 + 4096);
+      mem[8192 + 65] = 8;
+      // Identical content at a third address must share the first URL
+      mem.fill(7, 16384, 16384 + 4096);
+      env.ward_js_set_image_src(1, 1024, 4096, 0, mimeLen);
+      env.ward_js_set_image_src(2, 8192, 4096, 0, mimeLen);
+      env.ward_js_set_image_src(3, 16384, 4096, 0, mimeLen);
+      // WASM may reuse the memory as soon as the call returns
+      mem.fill(0, 1024, 16384 + 4096);
+      await until(() => [1, 2, 3].every(id => nodes.get(id).src));
+      assert.equal(created.length, 2, 'expected one URL per distinct content');
+      assert.equal(nodes.get(3).src, nodes.get(1).src);
+      assert.notEqual(nodes.get(2).src, nodes.get(1).src);
+    } finally {
+      URL.createObjectURL = origCreate;
+    }
+  });
 });
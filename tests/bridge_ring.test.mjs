@@ -0,0 +1,63 @@
+// bridge_ring.test.mjs — SPSC ring JS end (threaded build transport)
+
+import { describe, it } from 'node:test';
+import assert from 'node:assert/strict';
+import { ringPush, ringDrain } from './../lib/ward_ring.mjs';
+
+// A ring at offset 0 of its own buffer: [head][tail][cap][pad][data]
+function makeRing(cap) {
+  const buffer = new SharedArrayBuffer(16 + cap);
+  new Int32Array(buffer)[2] = cap;
+  return buffer;
+}
+
+const bytes = (n) => new Uint8Array(n).fill(n & 0xff);
+
+describe('SPSC ring', () => {
+  it('takes a record larger than the room left before the end once drained', () => {
+    const buffer = makeRing(64);
+    const lens = [];
+    const take = (ptr, len) => lens.push(len);
+    // Leave the write position at 32 with the ring empty
+    assert.ok(ringPush(buffer, 0, bytes(28)));
+    ringDrain(buffer, 0, take);
+    // 35 bytes need 40: not before the end (32 left), not at 0 yet (the
+    // skip marker is still unread), so the first try publishes the wrap
+    assert.equal(ringPush(buffer, 0, bytes(35)), false);
+    ringDrain(buffer, 0, take);
+    assert.ok(ringPush(buffer, 0, bytes(35)), 'retry after the wrap must succeed');
+    ringDrain(buffer, 0, take);
+    assert.deepEqual(lens, [28, 35]);
+  });
+
+  it('accepts a full-capacity record from any position', () => {
+    const buffer = makeRing(64);
+    for (let lead = 4; lead <= 56; lead += 4) {
+      assert.ok(ringPush(buffer, 0, bytes(lead - 4)));
+      ringDrain(buffer, 0, () => {});
+      let ok = ringPush(buffer, 0, bytes(60));
+      if (!ok) {
+        ringDrain(buffer, 0, () => {});
+        ok = ringPush(buffer, 0, bytes(60));
+      }
+      assert.ok(ok, `60-byte record after a ${lead - 4}-byte one`);
+      ringDrain(buffer, 0, () => {});
+    }
+  });
+
+  it('moves past a record whose handler throws and keeps draining', () => {
+    const buffer = makeRing(64);
+    ringPush(buffer, 0, bytes(4));
+    ringPush(buffer, 0, bytes(8));
+    const lens = [];
+    const errors = [];
+    const n = ringDrain(buffer, 0, (ptr, len) => {
+      if (len === 4) throw new Error('trap');
+      lens.push(len);
+    }, (err) => errors.push(err.message));
+    assert.equal(n, 2);
+    assert.deepEqual(lens, [8]);
+    assert.deepEqual(errors, ['trap']);
+    assert.equal(ringDrain(buffer, 0, () => {}), 0, 'nothing left to replay');
+  });
+});
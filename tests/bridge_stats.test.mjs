@@ -0,0 +1,55 @@
+// bridge_stats.test.mjs — Instrumented build (WARD_STATS) tests
+
+import { describe, it } from 'node:test';
+import assert from 'node:assert/strict';
+import { createWardInstance, createWardStatsInstance } from './helpers.mjs';
+
+describe('Instrumentation', () => {
+  it('is off for the plain build', async () => {
+    const { ward } = await createWardInstance();
+    assert.equal(ward.ward_stats, undefined);
+  });
+
+  it('counts allocations, flushes and DOM ops', async () => {
+    const { stats } = await createWardStatsInstance();
+
+    // Wait for 1s timer to fire + some margin
+    await new Promise(r => setTimeout(r, 1500));
+
+    const s = stats();
+    assert.equal(s.wasm.version, 1);
+    assert.ok(s.wasm.alloc_count.reduce((a, b) => a + b) > 0, 'expected allocations');
+    assert.ok(s.wasm.peak_bytes >= s.wasm.live_bytes);
+    assert.ok(s.wasm.live_bytes >= s.wasm.live_requested);
+
+    // Both sides of the flush agree
+    assert.ok(s.dom.flushes > 0, 'expected flushes');
+    assert.equal(s.dom.flushes, s.wasm.flush_count);
+    assert.equal(s.dom.bytes, s.wasm.flush_bytes);
+    assert.ok(s.dom.ops.CREATE_ELEMENT.count >= 2);
+    assert.ok(s.dom.ops.SET_TEXT.count >= 2);
+    assert.ok(s.dom.ops.SET_ATTR.count >= 1);
+
+    // Crossings: the timer went out through an import and came back
+    // through an export; the timer resolve ran a promise chain
+    assert.ok(s.crossings.imports.ward_set_timer >= 1);
+    assert.ok(s.crossings.exports.ward_timer_fire >= 1);
+    assert.ok(s.wasm.chain_resolves >= 1);
+    assert.ok(s.wasm.chain_max_depth >= 1);
+  });
+
+  it('dumps Chrome trace-event JSON', async () => {
+    const { trace } = await createWardStatsInstance();
+
+    // Wait for 1s timer to fire + some margin
+    await new Promise(r => setTimeout(r, 1500));
+
+    const t = JSON.parse(JSON.stringify(trace()));
+    assert.ok(Array.isArray(t.traceEvents));
+    const flush = t.traceEvents.find(e => e.name === 'ward_dom_flush');
+    assert.ok(flush, 'expected a flush span');
+    assert.equal(flush.ph, 'X');
+    assert.ok(flush.args.bytes > 0);
+    assert.ok(t.traceEvents.some(e => e.ph === 'C' && e.name === 'heap'));
+  });
+});
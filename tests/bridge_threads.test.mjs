@@ -0,0 +1,40 @@
+// bridge_threads.test.mjs — Threaded build (worker + shared memory) tests
+
+import { describe, it } from 'node:test';
+import assert from 'node:assert/strict';
+import { createWardThreadedInstance } from './helpers.mjs';
+
+describe('Threaded mode', () => {
+  it('applies DOM batches from the worker on the main thread', async () => {
+    const { root, terminate } = await createWardThreadedInstance();
+    try {
+      // Wait for 1s timer to fire + some margin
+      await new Promise(r => setTimeout(r, 1500));
+
+      const p = root.querySelector('p');
+      assert.ok(p, 'expected <p> element');
+      assert.equal(p.textContent, 'hello-ward');
+
+      const span = root.querySelector('span');
+      assert.ok(span, 'expected <span> element');
+      assert.equal(span.textContent, 'it-works');
+      assert.equal(span.getAttribute('class'), 'demo');
+    } finally {
+      terminate();
+    }
+  });
+
+  it('serves image imports over RPC against shared memory', async () => {
+    const { root, terminate } = await createWardThreadedInstance();
+    try {
+      // Wait for 1s timer to fire + some margin
+      await new Promise(r => setTimeout(r, 1500));
+
+      const img = root.querySelector('img');
+      assert.ok(img, 'expected <img> element');
+      assert.ok(img.src.startsWith('blob:'), `expected blob: URL, got ${img.src}`);
+    } finally {
+      terminate();
+    }
+  });
+});
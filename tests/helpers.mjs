@@ -4,6 +4,7 @@ import 'fake-indexeddb/auto';
 import { readFile } from 'node:fs/promises';
 import { JSDOM } from 'jsdom';
 import { loadWard } from './../lib/ward_bridge.mjs';
+import { loadWardThreaded } from './../lib/ward_threads.mjs';
 
 /**
  * Create a fresh ward instance with jsdom backing.
@@ -25,3 +26,39 @@ export async function createWardInstance() {
 
   return { ward: exports, root, dom, nodes, done };
 }
+
+/**
+ * Create a threaded ward instance: the shared-memory build runs in a
+ * worker_threads worker, jsdom stays on this thread.
+ * Returns { root, dom, nodes, done, terminate } — call terminate() when done.
+ */
+export async function createWardThreadedInstance() {
+  const dom = new JSDOM('<!DOCTYPE html><div id="ward-root"></div>');
+  const root = dom.window.document.getElementById('ward-root');
+
+  const wasmBytes = await readFile(
+    new URL('../build/node_ward_mt.wasm', import.meta.url)
+  );
+
+  const { nodes, done, terminate } = await loadWardThreaded(wasmBytes, root);
+
+  return { root, dom, nodes, done, terminate };
+}
+
+/**
+ * Create a ward instance from the instrumented build (WARD_STATS).
+ * Returns { ward, root, dom, nodes, done, stats, trace } — stats() and
+ * trace() read the counters and the Chrome trace-event log.
+ */
+export async function createWardStatsInstance() {
+  const dom = new JSDOM('<!DOCTYPE html><div id="ward-root"></div>');
+  const root = dom.window.document.getElementById('ward-root');
+
+  const wasmBytes = await readFile(
+    new URL('../build/node_ward_stats.wasm', import.meta.url)
+  );
+
+  const { exports, nodes, done, stats, trace } = await loadWard(wasmBytes, root);
+
+  return { ward: exports, root, dom, nodes, done, stats, trace };
+}